@@ -0,0 +1,91 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <malloc.h>
+#endif
+
+namespace bench
+{
+	std::atomic<Size> allocations{ 0 };
+
+	volatile Int64 sink = 0;
+
+	std::atomic<Size> heap_live{ 0 };
+	std::atomic<Size> heap_peak{ 0 };
+
+	void Report::add(const String& group, const String& container, const String& test, Size elements, Size ops, const Sample& sample, const Json& extra)
+	{
+		const double count = static_cast<double>(std::max<Size>(ops, 1));
+
+		Json result = {
+			{ "group", group },
+			{ "container", container },
+			{ "test", test },
+			{ "elements", elements },
+			{ "ops", ops },
+			{ "ns_per_op", sample.nanoseconds / count },
+			{ "allocs_per_op", static_cast<double>(sample.allocations) / count },
+			{ "peak_rss_kb", peak_rss_kb() }
+		};
+		if (extra.is_object())
+			result.update(extra);
+
+		std::printf("%-10s %-34s %-18s %9zu %9zu %12.2f ns/op %9.3f allocs/op\n",
+			group.c_str(), container.c_str(), test.c_str(), elements, ops,
+			sample.nanoseconds / count, static_cast<double>(sample.allocations) / count);
+
+		_results.push_back(std::move(result));
+	}
+
+	void Report::write(const Path& path) const
+	{
+		utils::json::write(path, Json{ { "peak_rss_kb", peak_rss_kb() }, { "results", _results } });
+	}
+}
+
+static void* counted_alloc(Size size, Size align)
+{
+	bench::allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* ptr = align <= alignof(std::max_align_t)
+		? std::malloc(size ? size : 1)
+		: std::aligned_alloc(align, (std::max<Size>(size, 1) + align - 1) / align * align);
+
+	if (!ptr)
+		throw std::bad_alloc{};
+
+#if defined(__linux__)
+	const Size bytes = malloc_usable_size(ptr);
+	const Size live = bench::heap_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	for (Size peak = bench::heap_peak.load(std::memory_order_relaxed); peak < live;)
+		if (bench::heap_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			break;
+#endif
+	return ptr;
+}
+
+static void counted_free(void* ptr)
+{
+#if defined(__linux__)
+	if (ptr)
+		bench::heap_live.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+#endif
+	std::free(ptr);
+}
+
+void* operator new(Size size) { return counted_alloc(size, alignof(std::max_align_t)); }
+void* operator new[](Size size) { return counted_alloc(size, alignof(std::max_align_t)); }
+void* operator new(Size size, std::align_val_t align) { return counted_alloc(size, static_cast<Size>(align)); }
+void* operator new[](Size size, std::align_val_t align) { return counted_alloc(size, static_cast<Size>(align)); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, Size) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, Size) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, Size, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, Size, std::align_val_t) noexcept { counted_free(ptr); }
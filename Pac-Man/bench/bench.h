@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.h"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace bench
+{
+	extern std::atomic<Size> allocations;
+
+	extern volatile Int64 sink;
+
+	// Heap bytes currently allocated through operator new and the high-water
+	// mark since the last reset_heap_peak(). Only tracked on Linux.
+	extern std::atomic<Size> heap_live;
+	extern std::atomic<Size> heap_peak;
+
+	inline void reset_heap_peak() { heap_peak.store(heap_live.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Sample
+	{
+		double nanoseconds;
+		Size allocations;
+	};
+
+	template<typename _Fty>
+	Sample measure(_Fty&& action)
+	{
+		const Size allocs = allocations.load(std::memory_order_relaxed);
+		const auto start = Clock::now();
+		action();
+		const auto stop = Clock::now();
+
+		return {
+			static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()),
+			allocations.load(std::memory_order_relaxed) - allocs
+		};
+	}
+
+	inline Int64 peak_rss_kb()
+	{
+#if defined(__linux__)
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+#else
+		return 0;
+#endif
+	}
+
+	class Report
+	{
+	private:
+		Json _results = Json::array();
+
+	public:
+		void add(const String& group, const String& container, const String& test, Size elements, Size ops, const Sample& sample, const Json& extra = nullptr);
+
+		inline const Json& results() const { return _results; }
+
+		void write(const Path& path) const;
+	};
+}
@@ -0,0 +1,450 @@
+#include "bench.h"
+
+#include "intrusive_list.h"
+#include "chunked_list.h"
+#include "slot_map.h"
+#include "small_vector.h"
+#include "concurrent_queue.h"
+
+#include <deque>
+
+namespace
+{
+	struct Item
+	{
+		Int64 id;
+		Int64 value;
+		double x;
+		double y;
+	};
+
+	struct HookedItem : Item, utils::IntrusiveListHook<>
+	{
+		HookedItem(const Item& item) : Item{ item } {}
+	};
+
+	inline Item make_item(Size id) { return { static_cast<Int64>(id), static_cast<Int64>(id * 7), 0.5, 1.5 }; }
+
+	inline Size search_ops(Size elements) { return std::clamp<Size>(50'000'000 / std::max<Size>(elements, 1), 10, 1000); }
+
+	std::vector<Size> random_indices(Size count, Size bound, UInt32 seed)
+	{
+		std::mt19937 rng{ seed };
+		std::vector<Size> indices(count);
+		for (Size& index : indices)
+			index = std::uniform_int_distribution<Size>{ 0, bound - 1 }(rng);
+		return indices;
+	}
+
+
+
+	// Per-container adaptors. "stable" containers keep element addresses across
+	// unrelated erasures, so erase-by-pointer collects its targets up front;
+	// the others have to locate the element by index before every erase.
+
+	template<typename _Ty>
+	struct Adaptor;
+
+	template<typename _Alloc>
+	struct Adaptor<utils::LinkedList<Item, _Alloc>>
+	{
+		using Container = utils::LinkedList<Item, _Alloc>;
+		static constexpr bool stable = true;
+		static constexpr bool fast_front = true;
+
+		static inline void push(Container& c, const Item& item) { c.push_back(item); }
+		static inline void pop_front(Container& c) { c.erase(c.begin()); }
+		static inline const Item& at(const Container& c, Size index) { return c[index]; }
+		static inline void erase(Container& c, const Item* item) { c.erase(item); }
+		static inline void clear(Container& c) { c.clear(); }
+	};
+
+	template<>
+	struct Adaptor<utils::ChunkedList<Item>>
+	{
+		using Container = utils::ChunkedList<Item>;
+		static constexpr bool stable = false;
+		static constexpr bool fast_front = true;
+
+		static inline void push(Container& c, const Item& item) { c.push_back(item); }
+		static inline void pop_front(Container& c) { c.erase(c.begin()); }
+		static inline const Item& at(const Container& c, Size index) { return c[index]; }
+		static inline void erase(Container& c, const Item* item) { c.erase(item); }
+		static inline void clear(Container& c) { c.clear(); }
+	};
+
+	template<>
+	struct Adaptor<std::list<Item>>
+	{
+		using Container = std::list<Item>;
+		static constexpr bool stable = true;
+		static constexpr bool fast_front = true;
+
+		static inline void push(Container& c, const Item& item) { c.push_back(item); }
+		static inline void pop_front(Container& c) { c.pop_front(); }
+		static inline const Item& at(const Container& c, Size index) { return *std::next(c.begin(), index); }
+		static inline void erase(Container& c, const Item* item) { c.erase(std::find_if(c.begin(), c.end(), [item](const Item& elem) { return &elem == item; })); }
+		static inline void clear(Container& c) { c.clear(); }
+	};
+
+	template<>
+	struct Adaptor<std::vector<Item>>
+	{
+		using Container = std::vector<Item>;
+		static constexpr bool stable = false;
+		static constexpr bool fast_front = false;
+
+		static inline void push(Container& c, const Item& item) { c.push_back(item); }
+		static inline void pop_front(Container& c) { c.erase(c.begin()); }
+		static inline const Item& at(const Container& c, Size index) { return c[index]; }
+		static inline void erase(Container& c, const Item* item) { c.erase(c.begin() + (item - c.data())); }
+		static inline void clear(Container& c) { c.clear(); }
+	};
+
+	template<>
+	struct Adaptor<std::deque<Item>>
+	{
+		using Container = std::deque<Item>;
+		static constexpr bool stable = false;
+		static constexpr bool fast_front = true;
+
+		static inline void push(Container& c, const Item& item) { c.push_back(item); }
+		static inline void pop_front(Container& c) { c.pop_front(); }
+		static inline const Item& at(const Container& c, Size index) { return c[index]; }
+		static inline void erase(Container& c, const Item* item)
+		{
+			c.erase(std::find_if(c.begin(), c.end(), [item](const Item& elem) { return &elem == item; }));
+		}
+		static inline void clear(Container& c) { c.clear(); }
+	};
+
+
+
+	template<typename _Container>
+	void bench_sequence(bench::Report& report, const String& name, Size elements)
+	{
+		using Ops = Adaptor<_Container>;
+
+		_Container container;
+		report.add("container", name, "push_back", elements, elements, bench::measure([&] {
+			for (Size i = 0; i < elements; ++i)
+				Ops::push(container, make_item(i));
+		}));
+
+		report.add("container", name, "iterate", elements, elements, bench::measure([&] {
+			Int64 sum = 0;
+			for (const Item& item : container)
+				sum += item.value;
+			bench::sink = sum;
+		}));
+
+		const Size lookups = search_ops(elements);
+		const std::vector<Size> indices = random_indices(lookups, elements, 7);
+		report.add("container", name, "indexed_access", elements, lookups, bench::measure([&] {
+			Int64 sum = 0;
+			for (Size index : indices)
+				sum += Ops::at(container, index).value;
+			bench::sink = sum;
+		}));
+
+		const Size churn = Ops::fast_front ? std::min<Size>(elements, 100'000) : search_ops(elements);
+		report.add("container", name, "churn", elements, churn, bench::measure([&] {
+			for (Size i = 0; i < churn; ++i)
+			{
+				Ops::pop_front(container);
+				Ops::push(container, make_item(elements + i));
+			}
+		}));
+
+		const Size erasures = std::min(search_ops(elements), elements / 2);
+		const std::vector<Size> targets = random_indices(erasures, elements / 2, 11);
+		if constexpr (Ops::stable)
+		{
+			std::vector<const Item*> pointers;
+			for (Size index : targets)
+				pointers.push_back(&Ops::at(container, index));
+			std::sort(pointers.begin(), pointers.end());
+			pointers.erase(std::unique(pointers.begin(), pointers.end()), pointers.end());
+
+			report.add("container", name, "erase_by_pointer", elements, pointers.size(), bench::measure([&] {
+				for (const Item* item : pointers)
+					Ops::erase(container, item);
+			}));
+		}
+		else
+		{
+			report.add("container", name, "erase_by_pointer", elements, erasures, bench::measure([&] {
+				for (Size index : targets)
+					Ops::erase(container, &Ops::at(container, index));
+			}));
+		}
+
+		const Size remaining = container.size();
+		report.add("container", name, "clear", remaining, remaining, bench::measure([&] { Ops::clear(container); }));
+	}
+
+	// Containers that are made and dropped empty, such as per-entity lists
+	// that usually stay empty, should not touch the heap.
+	template<typename _Container>
+	void bench_empty(bench::Report& report, const String& name, Size count)
+	{
+		report.add("container", name, "construct_empty", 0, count, bench::measure([&] {
+			Int64 total = 0;
+			for (Size i = 0; i < count; ++i)
+			{
+				_Container container;
+				total += static_cast<Int64>(container.size());
+			}
+			bench::sink = total;
+		}));
+	}
+
+	// Moves nodes between two lists of elements / 2 each: a whole list at
+	// once, then one node at a time, then a merge of two sorted lists. A
+	// node-based list should relink its nodes in place without allocating;
+	// "relinked" is 1 if the first spliced element kept its address.
+	template<typename _Container>
+	void bench_splice(bench::Report& report, const String& name, Size elements)
+	{
+		const auto fill = [elements](_Container& c, Size first) {
+			for (Size i = first; i < elements; i += 2)
+				c.push_back(make_item(i));
+		};
+
+		_Container left, right;
+		fill(left, 0);
+		fill(right, 1);
+		const Size moved = right.size();
+		const Item* first = &*right.begin();
+
+		const bench::Sample all = bench::measure([&] { left.splice(left.end(), right); });
+		const bool relinked = &*std::next(left.begin(), static_cast<std::ptrdiff_t>(left.size() - moved)) == first;
+		report.add("container", name, "splice_all", elements, 1, all, { { "relinked", relinked ? 1 : 0 } });
+
+		const Size count = left.size();
+		report.add("container", name, "splice_one", elements, count, bench::measure([&] {
+			for (Size i = 0; i < count; ++i)
+				right.splice(right.end(), left, left.begin());
+		}));
+
+		_Container evens, odds;
+		fill(evens, 0);
+		fill(odds, 1);
+		report.add("container", name, "merge", elements, elements, bench::measure([&] {
+			evens.merge(odds, [](const Item& a, const Item& b) { return a.id < b.id; });
+		}));
+		bench::sink = static_cast<Int64>(evens.size() + right.size());
+	}
+
+	void bench_intrusive(bench::Report& report, Size elements)
+	{
+		const String name = "utils::IntrusiveList";
+
+		std::vector<HookedItem> storage;
+		storage.reserve(elements);
+		for (Size i = 0; i < elements; ++i)
+			storage.emplace_back(make_item(i));
+
+		utils::IntrusiveList<HookedItem> list;
+		report.add("container", name, "push_back", elements, elements, bench::measure([&] {
+			for (HookedItem& item : storage)
+				list.push_back(item);
+		}));
+
+		report.add("container", name, "iterate", elements, elements, bench::measure([&] {
+			Int64 sum = 0;
+			for (const HookedItem& item : list)
+				sum += item.value;
+			bench::sink = sum;
+		}));
+
+		const Size erasures = std::min(search_ops(elements), elements / 2);
+		const std::vector<Size> targets = random_indices(erasures, elements, 11);
+		report.add("container", name, "erase_by_pointer", elements, erasures, bench::measure([&] {
+			for (Size index : targets)
+				list.erase(&storage[index]);
+		}));
+
+		const Size remaining = list.size();
+		report.add("container", name, "clear", remaining, remaining, bench::measure([&] { list.clear(); }));
+	}
+
+	void bench_slot_map(bench::Report& report, Size elements)
+	{
+		const String name = "utils::SlotMap";
+
+		utils::SlotMap<Item> map;
+		std::vector<utils::SlotMapHandle> handles;
+		handles.reserve(elements);
+
+		report.add("container", name, "push_back", elements, elements, bench::measure([&] {
+			for (Size i = 0; i < elements; ++i)
+				handles.push_back(map.insert(make_item(i)));
+		}));
+
+		report.add("container", name, "iterate", elements, elements, bench::measure([&] {
+			Int64 sum = 0;
+			for (const Item& item : map)
+				sum += item.value;
+			bench::sink = sum;
+		}));
+
+		const std::vector<Size> indices = random_indices(search_ops(elements), elements, 7);
+		report.add("container", name, "indexed_access", elements, indices.size(), bench::measure([&] {
+			Int64 sum = 0;
+			for (Size index : indices)
+				sum += map[handles[index]].value;
+			bench::sink = sum;
+		}));
+
+		const Size erasures = std::min(search_ops(elements), elements / 2);
+		const std::vector<Size> targets = random_indices(erasures, elements, 11);
+		report.add("container", name, "erase_by_pointer", elements, erasures, bench::measure([&] {
+			for (Size index : targets)
+				map.erase(handles[index]);
+		}));
+
+		const Size remaining = map.size();
+		report.add("container", name, "clear", remaining, remaining, bench::measure([&] { map.clear(); }));
+	}
+
+
+
+	template<typename _Vector>
+	void bench_small_lists(bench::Report& report, const String& name, Size lists)
+	{
+		std::mt19937 rng{ 3 };
+		std::vector<UInt32> sizes(lists);
+		for (UInt32& size : sizes)
+			size = std::uniform_int_distribution<UInt32>{ 0, 8 }(rng);
+
+		std::vector<_Vector> occupants(lists);
+		report.add("small", name, "fill_0_8", lists, lists, bench::measure([&] {
+			for (Size i = 0; i < lists; ++i)
+				for (UInt32 j = 0; j < sizes[i]; ++j)
+					occupants[i].emplace_back(static_cast<UInt32>(i + j));
+		}));
+
+		report.add("small", name, "iterate", lists, lists, bench::measure([&] {
+			Int64 sum = 0;
+			for (const _Vector& list : occupants)
+				for (UInt32 id : list)
+					sum += id;
+			bench::sink = sum;
+		}));
+
+		report.add("small", name, "move", lists, lists, bench::measure([&] {
+			std::vector<_Vector> moved;
+			moved.reserve(lists);
+			for (_Vector& list : occupants)
+				moved.push_back(std::move(list));
+			occupants = std::move(moved);
+		}));
+
+		report.add("small", name, "build_and_drop", lists, lists, bench::measure([&] {
+			Int64 sum = 0;
+			for (Size i = 0; i < lists; ++i)
+			{
+				_Vector candidates;
+				for (UInt32 j = 0; j < sizes[i]; ++j)
+					candidates.push_back(j);
+				sum += static_cast<Int64>(candidates.size());
+			}
+			bench::sink = sum;
+		}));
+	}
+
+
+
+	struct Message
+	{
+		Int64 sent;
+		UInt32 producer;
+		UInt32 sequence;
+	};
+
+	inline Int64 now_ns() { return std::chrono::duration_cast<std::chrono::nanoseconds>(bench::Clock::now().time_since_epoch()).count(); }
+
+	template<typename _Queue>
+	void bench_queue(bench::Report& report, const String& name, Size producers, Size messages)
+	{
+		_Queue queue{ 1024 };
+		const Size per_producer = messages / producers;
+		const Size total = per_producer * producers;
+
+		double latency = 0;
+		const bench::Sample sample = bench::measure([&] {
+			std::vector<std::thread> threads;
+			for (Size p = 0; p < producers; ++p)
+			{
+				threads.emplace_back([&queue, p, per_producer] {
+					for (Size i = 0; i < per_producer; ++i)
+						queue.push_wait(Message{ now_ns(), static_cast<UInt32>(p), static_cast<UInt32>(i) });
+				});
+			}
+
+			Message batch[64];
+			for (Size received = 0; received < total;)
+			{
+				Size count = queue.pop_batch(batch, 64);
+				if (count == 0)
+					queue.pop_wait(batch[0]), count = 1;
+
+				const Int64 now = now_ns();
+				for (Size i = 0; i < count; ++i)
+					latency += static_cast<double>(now - batch[i].sent);
+				received += count;
+			}
+
+			for (std::thread& thread : threads)
+				thread.join();
+		});
+
+		report.add("queue", name, std::to_string(producers) + "_producers", total, total, sample, { { "mean_latency_ns", latency / static_cast<double>(total) } });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const Path output = argc > 1 ? Path{ argv[1] } : "container_bench.json"_p;
+	const bool quick = argc > 2 && String{ argv[2] } == "--quick";
+
+	bench::Report report;
+
+	const std::vector<Size> sizes = quick ? std::vector<Size>{ 1'000, 10'000 } : std::vector<Size>{ 1'000, 10'000, 100'000, 1'000'000 };
+	for (Size elements : sizes)
+	{
+		bench_sequence<utils::LinkedList<Item>>(report, "utils::LinkedList<PoolAllocator>", elements);
+		bench_sequence<utils::LinkedList<Item, std::allocator<Item>>>(report, "utils::LinkedList<std::allocator>", elements);
+		bench_sequence<utils::ChunkedList<Item>>(report, "utils::ChunkedList", elements);
+		bench_intrusive(report, elements);
+		bench_slot_map(report, elements);
+		bench_sequence<std::list<Item>>(report, "std::list", elements);
+		bench_sequence<std::vector<Item>>(report, "std::vector", elements);
+		bench_sequence<std::deque<Item>>(report, "std::deque", elements);
+
+		bench_splice<utils::LinkedList<Item>>(report, "utils::LinkedList<PoolAllocator>", elements);
+		bench_splice<utils::LinkedList<Item, std::allocator<Item>>>(report, "utils::LinkedList<std::allocator>", elements);
+		bench_splice<std::list<Item>>(report, "std::list", elements);
+	}
+
+	bench_empty<utils::LinkedList<Item>>(report, "utils::LinkedList<PoolAllocator>", 10'000);
+	bench_empty<utils::LinkedList<Item, std::allocator<Item>>>(report, "utils::LinkedList<std::allocator>", 10'000);
+	bench_empty<std::list<Item>>(report, "std::list", 10'000);
+
+	const Size lists = quick ? 10'000 : 1'000'000;
+	bench_small_lists<utils::SmallVector<UInt32, 4>>(report, "utils::SmallVector<UInt32, 4>", lists);
+	bench_small_lists<utils::SmallVector<UInt32, 8>>(report, "utils::SmallVector<UInt32, 8>", lists);
+	bench_small_lists<std::vector<UInt32>>(report, "std::vector<UInt32>", lists);
+
+	const Size messages = quick ? 100'000 : 2'000'000;
+	const Size max_producers = std::clamp<Size>(std::thread::hardware_concurrency() - 1, 1, 8);
+	bench_queue<utils::SpscQueue<Message>>(report, "utils::SpscQueue", 1, messages);
+	for (Size producers = 1; producers <= max_producers; producers *= 2)
+		bench_queue<utils::MpscQueue<Message>>(report, "utils::MpscQueue", producers, messages);
+
+	report.write(output);
+	std::printf("peak RSS: %lld KB, results written to %s\n", static_cast<long long>(bench::peak_rss_kb()), output.string().c_str());
+
+	return 0;
+}
@@ -0,0 +1,1136 @@
+#include "bench.h"
+
+#include "json_reflect.h"
+#include "json_arena.h"
+#include "json_flat.h"
+#include "json_intern.h"
+#include "json_keys.h"
+#include "json_lazy.h"
+#include "json_lines.h"
+#include "json_save.h"
+#include "resource_async.h"
+#include "resource_cache.h"
+#include "resource_pack.h"
+#include "resource_vfs.h"
+#include "resource_watch.h"
+#include "thread_pool.h"
+
+namespace
+{
+	struct Spawn
+	{
+		String type;
+		Int32 x;
+		Int32 y;
+	};
+
+	void to_json(Json& json, const Spawn& spawn) { json = { { "type", spawn.type }, { "x", spawn.x }, { "y", spawn.y } }; }
+	void from_json(const Json& json, Spawn& spawn)
+	{
+		spawn.type = json.at("type").get<String>();
+		spawn.x = json.at("x").get<Int32>();
+		spawn.y = json.at("y").get<Int32>();
+	}
+
+	class Level : public utils::json::JsonSerializable
+	{
+	public:
+		String name;
+		Int32 width = 0;
+		Int32 height = 0;
+		std::vector<UInt8> tiles;
+		std::vector<Spawn> spawns;
+
+	public:
+		class Reader : public utils::json::JsonSaxHandler
+		{
+		private:
+			Level& _level;
+			String _section;
+
+		public:
+			Reader(Level& level) : _level{ level } {}
+
+		protected:
+			bool enter(bool) override
+			{
+				if (depth() == 1)
+					_section = key();
+				else if (depth() == 2 && _section == "spawns")
+					capture();
+				return true;
+			}
+
+			bool value(Json&& value) override
+			{
+				if (depth() == 1)
+				{
+					if (key() == "name")
+						_level.name = value.get<String>();
+					else if (key() == "width")
+						_level.width = value.get<Int32>();
+					else if (key() == "height")
+						_level.height = value.get<Int32>();
+				}
+				else if (depth() == 2)
+				{
+					if (_section == "tiles")
+						_level.tiles.push_back(value.get<UInt8>());
+					else if (_section == "spawns")
+						_level.spawns.push_back(value.get<Spawn>());
+				}
+				return true;
+			}
+		};
+
+	public:
+		Json serialize() const override
+		{
+			return {
+				{ "name", name },
+				{ "width", width },
+				{ "height", height },
+				{ "tiles", tiles },
+				{ "spawns", spawns }
+			};
+		}
+
+		void deserialize(const Json& json) override
+		{
+			name = json.at("name").get<String>();
+			width = json.at("width").get<Int32>();
+			height = json.at("height").get<Int32>();
+			tiles = json.at("tiles").get<std::vector<UInt8>>();
+			spawns = json.at("spawns").get<std::vector<Spawn>>();
+		}
+
+		inline Reader stream_deserializer() { return *this; }
+	};
+
+	static_assert(utils::json::JsonStreamDeserializable<Level>);
+
+	struct ReflectedSpawn
+	{
+		String type;
+		Int32 x = 0;
+		Int32 y = 0;
+
+		static constexpr auto json_fields()
+		{
+			using utils::json::field;
+			return utils::json::fields(field("type", &ReflectedSpawn::type), field("x", &ReflectedSpawn::x), field("y", &ReflectedSpawn::y));
+		}
+	};
+
+	struct ReflectedLevel
+	{
+		String name;
+		Int32 width = 0;
+		Int32 height = 0;
+		std::vector<UInt8> tiles;
+		std::vector<ReflectedSpawn> spawns;
+
+		static constexpr auto json_fields()
+		{
+			using utils::json::field;
+			return utils::json::fields(
+				field("name", &ReflectedLevel::name),
+				field("width", &ReflectedLevel::width),
+				field("height", &ReflectedLevel::height),
+				field("tiles", &ReflectedLevel::tiles),
+				field("spawns", &ReflectedLevel::spawns)
+			);
+		}
+	};
+
+	static_assert(utils::json::JsonReflectable<ReflectedLevel>);
+
+	Level make_level(Int32 side, Size spawn_count)
+	{
+		static const char* const types[] = { "pellet", "power", "ghost", "fruit" };
+
+		std::mt19937 rng{ 9 };
+		Level level;
+		level.name = "benchmark";
+		level.width = side;
+		level.height = side;
+		level.tiles.resize(static_cast<Size>(side) * side);
+		for (UInt8& tile : level.tiles)
+			tile = static_cast<UInt8>(std::uniform_int_distribution<int>{ 0, 15 }(rng));
+		for (Size i = 0; i < spawn_count; ++i)
+		{
+			level.spawns.push_back({
+				types[i % 4],
+				std::uniform_int_distribution<Int32>{ 0, side - 1 }(rng),
+				std::uniform_int_distribution<Int32>{ 0, side - 1 }(rng)
+			});
+		}
+		return level;
+	}
+
+	Json make_document(Size target_bytes)
+	{
+		std::mt19937 rng{ 5 };
+		Json entries = Json::array();
+		for (Size bytes = 0; bytes < target_bytes; bytes += 96)
+		{
+			entries.push_back({
+				{ "id", entries.size() },
+				{ "name", "entry_" + std::to_string(entries.size()) },
+				{ "score", std::uniform_real_distribution<double>{ 0, 1000 }(rng) },
+				{ "flags", { true, false, nullptr } }
+			});
+		}
+		return { { "version", 1 }, { "entries", std::move(entries) } };
+	}
+
+	void bench_read_modes(bench::Report& report, const resource::Folder& folder, const String& filename, Size target_bytes, Size runs)
+	{
+		utils::json::write(folder.pathOf(filename), make_document(target_bytes));
+		const Size bytes = static_cast<Size>(std::filesystem::file_size(folder.pathOf(filename)));
+		const String test = "read_" + std::to_string(target_bytes / 1024) + "KB";
+
+		report.add("json", "stream", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				std::ifstream input{ folder.pathOf(filename) };
+				bench::sink = static_cast<Int64>(utils::json::read(input).size());
+			}
+		}));
+
+		report.add("json", "mapped", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				bench::sink = static_cast<Int64>(utils::json::read_mapped(folder.pathOf(filename)).size());
+		}));
+	}
+
+	void bench_arena(bench::Report& report, const Path& path, const String& test, Size runs)
+	{
+		const utils::MappedFile file{ path };
+
+		report.add("json", "Json", test + "_parse", file.size(), runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				Json json = utils::json::read(file);
+				bench::sink = static_cast<Int64>(json.size());
+			}
+		}));
+
+		utils::Arena arena;
+		report.add("json", "ArenaJson", test + "_parse", file.size(), runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				bench::sink = static_cast<Int64>(utils::json::read(file, arena).size());
+				arena.reset();
+			}
+		}), { { "arena_bytes", arena.capacity() } });
+
+		// Parse outside the timer, time only the teardown.
+		double nanoseconds = 0;
+		for (Size run = 0; run < runs; ++run)
+		{
+			auto json = std::make_unique<Json>(utils::json::read(file));
+			nanoseconds += bench::measure([&] { json.reset(); }).nanoseconds;
+		}
+		report.add("json", "Json", test + "_destroy", file.size(), runs, { nanoseconds, 0 });
+
+		nanoseconds = 0;
+		for (Size run = 0; run < runs; ++run)
+		{
+			utils::json::read(file, arena);
+			nanoseconds += bench::measure([&] { arena.reset(); }).nanoseconds;
+		}
+		report.add("json", "ArenaJson", test + "_destroy", file.size(), runs, { nanoseconds, 0 });
+	}
+
+	// Records shaped like actor/tile descriptions: many small objects with a
+	// fixed set of keys, read back field by field through opt().
+	Json make_records(Size count)
+	{
+		static const char* const kinds[] = { "pacman", "blinky", "pinky", "inky", "clyde" };
+
+		std::mt19937 rng{ 11 };
+		Json records = Json::array();
+		for (Size i = 0; i < count; ++i)
+		{
+			records.push_back({
+				{ "id", i },
+				{ "kind", kinds[i % 5] },
+				{ "x", std::uniform_int_distribution<Int32>{ 0, 27 }(rng) },
+				{ "y", std::uniform_int_distribution<Int32>{ 0, 30 }(rng) },
+				{ "speed", std::uniform_real_distribution<double>{ 0, 2 }(rng) },
+				{ "direction", static_cast<Int32>(i % 4) },
+				{ "frame", static_cast<Int32>(i % 8) },
+				{ "alive", (i % 7) != 0 },
+				{ "score", static_cast<Int32>(i * 10) },
+				{ "timer", std::uniform_real_distribution<double>{ 0, 10 }(rng) }
+			});
+		}
+		return records;
+	}
+
+	template<typename _Json>
+	Int64 visit_records(const _Json& records)
+	{
+		using utils::json::opt;
+
+		Int64 total = 0;
+		for (const _Json& record : records)
+		{
+			total += opt<Int64>(record, "id", 0);
+			total += static_cast<Int64>(opt<String>(record, "kind", "").size());
+			total += opt<Int32>(record, "x", 0) + opt<Int32>(record, "y", 0);
+			total += static_cast<Int64>(opt<double>(record, "speed", 0));
+			total += opt<Int32>(record, "direction", 0) + opt<Int32>(record, "frame", 0);
+			total += opt<bool>(record, "alive", false) ? 1 : 0;
+			total += opt<Int32>(record, "score", 0);
+			total += static_cast<Int64>(opt<double>(record, "timer", 0));
+			total += opt<Int32>(record, "missing", 0);
+		}
+		return total;
+	}
+
+	struct Actor
+	{
+		Int64 id = 0;
+		String kind;
+		Int32 x = 0;
+		Int32 y = 0;
+		double speed = 0;
+		Int32 direction = 0;
+		Int32 frame = 0;
+		bool alive = false;
+		Int32 score = 0;
+		double timer = 0;
+	};
+
+	Int64 checksum(const Actor& actor)
+	{
+		return actor.id + static_cast<Int64>(actor.kind.size()) + actor.x + actor.y + actor.direction + actor.frame + actor.alive + actor.score + static_cast<Int64>(actor.speed + actor.timer);
+	}
+
+	void bench_keys(bench::Report& report, const Path& path, Size count, Size runs)
+	{
+		using namespace utils::json::literals;
+		using utils::json::opt;
+
+		const Json records = utils::json::read_mapped(path);
+
+		report.add("json", "opt_string", "records_deserialize", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				Int64 total = 0;
+				for (const Json& record : records)
+				{
+					Actor actor;
+					opt(record, "id", actor.id);
+					opt(record, "kind", actor.kind);
+					opt(record, "x", actor.x);
+					opt(record, "y", actor.y);
+					opt(record, "speed", actor.speed);
+					opt(record, "direction", actor.direction);
+					opt(record, "frame", actor.frame);
+					opt(record, "alive", actor.alive);
+					opt(record, "score", actor.score);
+					opt(record, "timer", actor.timer);
+					total += checksum(actor);
+				}
+				bench::sink = total;
+			}
+		}));
+
+		report.add("json", "opt_key", "records_deserialize", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				Int64 total = 0;
+				for (const Json& record : records)
+				{
+					Actor actor;
+					opt(record, "id"_key, actor.id);
+					opt(record, "kind"_key, actor.kind);
+					opt(record, "x"_key, actor.x);
+					opt(record, "y"_key, actor.y);
+					opt(record, "speed"_key, actor.speed);
+					opt(record, "direction"_key, actor.direction);
+					opt(record, "frame"_key, actor.frame);
+					opt(record, "alive"_key, actor.alive);
+					opt(record, "score"_key, actor.score);
+					opt(record, "timer"_key, actor.timer);
+					total += checksum(actor);
+				}
+				bench::sink = total;
+			}
+		}));
+
+		static constexpr utils::json::KeySet keys{ "id", "kind", "x", "y", "speed", "direction", "frame", "alive", "score", "timer" };
+		report.add("json", "key_set", "records_deserialize", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				Int64 total = 0;
+				for (const Json& record : records)
+				{
+					Actor actor;
+					keys.read(record, actor.id, actor.kind, actor.x, actor.y, actor.speed, actor.direction, actor.frame, actor.alive, actor.score, actor.timer);
+					total += checksum(actor);
+				}
+				bench::sink = total;
+			}
+		}));
+	}
+
+	template<typename _Json>
+	void read_records(const utils::MappedFile& file, _Json& records)
+	{
+		if constexpr (std::same_as<_Json, Json>)
+			records = utils::json::read(file);
+		else utils::json::read(file, records);
+	}
+
+	template<typename _Json>
+	void bench_flat_variant(bench::Report& report, const String& name, const utils::MappedFile& file, Size count, Size runs)
+	{
+		const Size before = bench::heap_live.load(std::memory_order_relaxed);
+		bench::reset_heap_peak();
+		_Json records;
+		read_records(file, records);
+		const Size heap = bench::heap_peak.load(std::memory_order_relaxed) - before;
+		records = nullptr;
+
+		report.add("json", name, "records_parse", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				read_records(file, records);
+				bench::sink = static_cast<Int64>(records.size());
+			}
+		}), { { "file_bytes", file.size() }, { "peak_heap_bytes", heap } });
+
+		report.add("json", name, "records_opt", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				bench::sink = visit_records(records);
+		}));
+
+		report.add("json", name, "records_parse_opt", count, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				_Json parsed;
+				read_records(file, parsed);
+				bench::sink = visit_records(parsed);
+			}
+		}));
+	}
+
+	void bench_flat(bench::Report& report, const resource::Folder& folder, Size count, Size runs)
+	{
+		const Path path = folder.pathOf("records.json");
+		utils::json::write(path, make_records(count));
+		const utils::MappedFile file{ path };
+
+		bench_flat_variant<Json>(report, "Json", file, count, runs);
+		bench_flat_variant<utils::json::FlatJson>(report, "FlatJson", file, count, runs);
+	}
+
+	struct GameEvent
+	{
+		String type;
+		Int64 tick = 0;
+		Int32 x = 0;
+		Int32 y = 0;
+		Int32 score = 0;
+
+		static constexpr auto json_fields()
+		{
+			using utils::json::field;
+			return utils::json::fields(field("type", &GameEvent::type), field("tick", &GameEvent::tick), field("x", &GameEvent::x), field("y", &GameEvent::y), field("score", &GameEvent::score));
+		}
+	};
+
+	GameEvent make_event(Size index)
+	{
+		static const char* const types[] = { "move", "pellet", "power", "ghost_eaten", "death" };
+		return { types[index % 5], static_cast<Int64>(index), static_cast<Int32>(index % 28), static_cast<Int32>(index % 31), static_cast<Int32>(index * 10) };
+	}
+
+	// An event log written as one big array versus appended as JSON Lines,
+	// then read back.
+	void bench_lines(bench::Report& report, const resource::Folder& folder, Size count)
+	{
+		const Path array_path = folder.pathOf("events.json");
+		const Path lines_path = folder.pathOf("events.jsonl");
+
+		report.add("json", "array", "events_write", count, 1, bench::measure([&] {
+			Json events = Json::array();
+			for (Size i = 0; i < count; ++i)
+				events.push_back(make_event(i));
+			utils::json::write(array_path, events);
+		}));
+
+		std::filesystem::remove(lines_path);
+		report.add("json", "jsonl_dom", "events_write", count, 1, bench::measure([&] {
+			utils::json::JsonLinesWriter writer{ lines_path, false };
+			for (Size i = 0; i < count; ++i)
+				writer.write(Json(make_event(i)));
+		}));
+
+		report.add("json", "jsonl_reflected", "events_write", count, 1, bench::measure([&] {
+			utils::json::JsonLinesWriter writer{ lines_path, false };
+			for (Size i = 0; i < count; ++i)
+				writer.write(make_event(i));
+		}));
+
+		Size before = bench::heap_live.load(std::memory_order_relaxed);
+		bench::reset_heap_peak();
+		bench::Sample sample = bench::measure([&] {
+			Int64 total = 0;
+			for (const Json& event : utils::json::read_mapped(array_path))
+				total += event["score"].get<Int64>();
+			bench::sink = total;
+		});
+		report.add("json", "array", "events_read", count, 1, sample, { { "peak_heap_bytes", bench::heap_peak.load(std::memory_order_relaxed) - before } });
+
+		before = bench::heap_live.load(std::memory_order_relaxed);
+		bench::reset_heap_peak();
+		sample = bench::measure([&] {
+			utils::json::JsonLinesReader reader{ lines_path };
+			GameEvent event;
+			Int64 total = 0;
+			while (reader.next(event))
+				total += event.score;
+			bench::sink = total;
+		});
+		report.add("json", "jsonl_reflected", "events_read", count, 1, sample, { { "peak_heap_bytes", bench::heap_peak.load(std::memory_order_relaxed) - before } });
+	}
+
+	// Repeated saves of one state file where only a field changes between
+	// saves, as with settings or progress files.
+	void bench_save(bench::Report& report, const resource::Folder& folder, Size target_bytes, Size runs)
+	{
+		Json state = make_document(target_bytes);
+		const Size bytes = state.dump().size();
+		const String test = "save_" + std::to_string(target_bytes / 1024) + "KB";
+
+		report.add("json", "write", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				state["version"] = run;
+				utils::json::write(folder.pathOf("state_write.json"), state);
+			}
+		}));
+
+		report.add("json", "atomic_save", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				state["version"] = run;
+				utils::json::save(folder.pathOf("state_save.json"), state);
+			}
+		}));
+
+		utils::json::JsonJournal journal{ folder.pathOf("state_journal.json"), 3 * runs + 1 };
+		journal.load();
+		journal.save(state);
+		report.add("json", "journal_diff", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				state["version"] = run + 1;
+				journal.save(state);
+			}
+		}));
+
+		const Json::json_pointer version{ "/version" };
+		report.add("json", "journal_pointer", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				journal.save(version, run + 1);
+		}));
+
+		report.add("json", "journal_merge", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				journal.merge({ { "version", run } });
+		}));
+
+		const Size journal_bytes = journal.journal_bytes();
+		report.add("json", "journal_compact", test, bytes, 1, bench::measure([&] { journal.compact(); }), { { "journal_bytes", journal_bytes } });
+	}
+
+	// Touches two top-level members and one nested entry of a document
+	// written by bench_read_modes, the way a loader peeks at a header.
+	void bench_lazy(bench::Report& report, const resource::Folder& folder, const String& filename, Size runs)
+	{
+		const Size bytes = static_cast<Size>(std::filesystem::file_size(folder.pathOf(filename)));
+		const String test = "peek_" + std::to_string(bytes / 1024) + "KB";
+
+		report.add("json", "Json", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				Json json;
+				folder.readJson(filename, json);
+				bench::sink = utils::json::opt<Int64>(json, "version", 0) + static_cast<Int64>(json["entries"].size());
+				bench::sink = utils::json::opt<Int64>(json["entries"][10], "id", 0);
+			}
+		}));
+
+		report.add("json", "LazyJson", test, bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				utils::json::LazyJson json;
+				folder.readLazyJson(filename, json);
+				const utils::json::LazyJson entries = json.at("entries");
+				bench::sink = utils::json::opt<Int64>(json, "version", 0) + static_cast<Int64>(entries.size());
+				bench::sink = utils::json::opt<Int64>(entries.at(10), "id", 0);
+			}
+		}));
+	}
+
+	// Replay-like stream of frames: the same keys and a handful of short
+	// string values repeated in every frame.
+	void make_replay(const Path& path, Size target_bytes)
+	{
+		static const char* const ghosts[] = { "blinky", "pinky", "inky", "clyde" };
+		static const char* const directions[] = { "up", "down", "left", "right" };
+		static const char* const modes[] = { "scatter", "chase", "frightened", "eaten" };
+
+		std::mt19937 rng{ 13 };
+		std::ofstream output{ path, std::ios::binary };
+		String buffer = "[";
+		Size bytes = 0;
+		for (Size frame = 0; bytes < target_bytes; ++frame)
+		{
+			if (frame > 0)
+				buffer += ',';
+
+			buffer += "{\"frame_number\":" + std::to_string(frame);
+			buffer += ",\"elapsed_seconds\":" + std::to_string(frame / 60.0);
+			buffer += ",\"player_state\":{\"position_x\":" + std::to_string(rng() % 28) + ",\"position_y\":" + std::to_string(rng() % 31);
+			buffer += ",\"requested_direction\":\"" + String{ directions[rng() % 4] } + "\",\"remaining_lives\":" + std::to_string(3 - frame % 3) + "}";
+			buffer += ",\"ghost_states\":[";
+			for (Size i = 0; i < 4; ++i)
+			{
+				buffer += i > 0 ? ",{" : "{";
+				buffer += "\"ghost_name\":\"" + String{ ghosts[i] } + "\",\"position_x\":" + std::to_string(rng() % 28) + ",\"position_y\":" + std::to_string(rng() % 31);
+				buffer += ",\"behaviour_mode\":\"" + String{ modes[rng() % 4] } + "\",\"frightened_timer\":" + std::to_string(rng() % 600) + "}";
+			}
+			buffer += "],\"score_total\":" + std::to_string(frame * 10) + "}";
+
+			if (buffer.size() >= 1024 * 1024)
+			{
+				output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+				bytes += buffer.size();
+				buffer.clear();
+			}
+		}
+		buffer += "]";
+		output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	template<typename _Fty>
+	void bench_intern_variant(bench::Report& report, const String& name, const utils::MappedFile& file, _Fty&& load)
+	{
+		const Size before = bench::heap_live.load(std::memory_order_relaxed);
+		bench::reset_heap_peak();
+		Size retained = 0;
+		const bench::Sample sample = bench::measure([&] { retained = load(); });
+		const Size peak = bench::heap_peak.load(std::memory_order_relaxed) - before;
+
+		report.add("json", name, "replay_load", file.size(), 1, sample, { { "file_bytes", file.size() }, { "dom_heap_bytes", retained - before }, { "peak_heap_bytes", peak } });
+	}
+
+	void bench_intern(bench::Report& report, const resource::Folder& folder, Size target_bytes)
+	{
+		const Path path = folder.pathOf("replay.json");
+		make_replay(path, target_bytes);
+		const utils::MappedFile file{ path };
+
+		bench_intern_variant(report, "Json", file, [&] {
+			const Json json = utils::json::read(file);
+			return bench::heap_live.load(std::memory_order_relaxed);
+		});
+
+		bench_intern_variant(report, "interned_keys", file, [&] {
+			utils::StringPool pool;
+			utils::json::InternedJson json;
+			utils::json::read(file, json, pool);
+			return bench::heap_live.load(std::memory_order_relaxed);
+		});
+
+		bench_intern_variant(report, "interned_keys_values", file, [&] {
+			utils::StringPool pool{ 16 };
+			utils::json::InternedJson json;
+			utils::json::read(file, json, pool);
+			return bench::heap_live.load(std::memory_order_relaxed);
+		});
+
+		std::filesystem::remove(path);
+	}
+
+	std::vector<Path> collect_json_files(const Path& root)
+	{
+		std::vector<Path> files;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator{ root })
+			if (entry.is_regular_file() && entry.path().extension() == ".json")
+				files.push_back(std::filesystem::relative(entry.path(), root));
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	void make_data_tree(const resource::Folder& folder, Size file_count)
+	{
+		for (Size i = 0; i < file_count; ++i)
+		{
+			const resource::Folder sub = folder.folder("pack_" + std::to_string(i % 8));
+			std::filesystem::create_directories(sub.path());
+			utils::json::write(sub.pathOf("file_" + std::to_string(i) + ".json"), make_document(1024 << (i % 8)));
+		}
+	}
+
+	void bench_data_tree(bench::Report& report, const resource::Folder& data, const Path& cache_dir)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		Size bytes = 0;
+		for (const Path& file : files)
+			bytes += static_cast<Size>(std::filesystem::file_size(data.pathOf(file)));
+
+		const auto load_all = [&] {
+			Json json;
+			for (const Path& file : files)
+			{
+				data.readJson(file, json);
+				bench::sink = static_cast<Int64>(json.size());
+			}
+		};
+
+		resource::JsonCache::disable();
+
+		std::vector<Path> paths;
+		for (const Path& file : files)
+			paths.push_back(data.pathOf(file));
+
+		const Size max_threads = std::max<Size>(4, utils::ThreadPool::default_size());
+		for (Size threads = 1; threads <= max_threads; threads *= 2)
+		{
+			report.add("json", "read_many", "threads_" + std::to_string(threads), bytes, files.size(), bench::measure([&] {
+				bench::sink = static_cast<Int64>(utils::json::read_many(paths, threads).size());
+			}), { { "files", files.size() }, { "threads", threads }, { "cores", std::thread::hardware_concurrency() } });
+		}
+		report.add("json", "readJsonBatch", "shared_pool", bytes, files.size(), bench::measure([&] {
+			bench::sink = static_cast<Int64>(data.readJsonBatch(files).size());
+		}), { { "files", files.size() }, { "cores", std::thread::hardware_concurrency() } });
+
+		report.add("json", "text", "startup", bytes, files.size(), bench::measure(load_all), { { "files", files.size() } });
+
+		for (const auto& [name, format] : { std::pair{ "cbor", resource::JsonCache::Format::Cbor }, std::pair{ "msgpack", resource::JsonCache::Format::MessagePack } })
+		{
+			resource::JsonCache::enable(cache_dir, format);
+			resource::JsonCache::active()->clear();
+			report.add("json", String{ name } + " cache", "startup_cold", bytes, files.size(), bench::measure(load_all), { { "files", files.size() } });
+			report.add("json", String{ name } + " cache", "startup_warm", bytes, files.size(), bench::measure(load_all), { { "files", files.size() } });
+			resource::JsonCache::active()->clear();
+		}
+		resource::JsonCache::disable();
+	}
+
+	void bench_reflected(bench::Report& report, const resource::Folder& folder, const String& filename, Level& level, Size bytes, Size runs)
+	{
+		ReflectedLevel reflected;
+		folder.readAndInject(filename, reflected);
+
+		Size heap = 0;
+		const bench::Sample load = bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+			{
+				ReflectedLevel loaded;
+				const Size before = bench::heap_live.load(std::memory_order_relaxed);
+				bench::reset_heap_peak();
+				folder.readAndInject(filename, loaded);
+				heap = std::max(heap, bench::heap_peak.load(std::memory_order_relaxed) - before);
+				bench::sink = static_cast<Int64>(loaded.tiles.size() + loaded.spawns.size());
+			}
+		});
+		report.add("json", "reflected", "load_level", bytes, runs, load, { { "file_bytes", bytes }, { "peak_heap_bytes", heap } });
+
+		report.add("json", "dom", "save_level", bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				folder.extractAndWrite("save.json", level);
+		}));
+		report.add("json", "reflected", "save_level", bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				folder.extractAndWrite("save.json", reflected);
+		}));
+
+		report.add("json", "dom", "to_cbor", bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				bench::sink = static_cast<Int64>(Json::to_cbor(level.serialize()).size());
+		}));
+		report.add("json", "reflected", "to_cbor", bytes, runs, bench::measure([&] {
+			for (Size run = 0; run < runs; ++run)
+				bench::sink = static_cast<Int64>(utils::json::write_cbor(reflected).size());
+		}));
+	}
+
+	template<typename _Fty>
+	void bench_load(bench::Report& report, const String& name, const resource::Folder& folder, const String& filename, Size bytes, Size runs, _Fty&& load)
+	{
+		Size heap = 0;
+		double nanoseconds = 0;
+		Size allocations = 0;
+		for (Size run = 0; run < runs; ++run)
+		{
+			Level level;
+			const Size before = bench::heap_live.load(std::memory_order_relaxed);
+			bench::reset_heap_peak();
+			const bench::Sample sample = bench::measure([&] { load(folder, filename, level); });
+			heap = std::max(heap, bench::heap_peak.load(std::memory_order_relaxed) - before);
+			nanoseconds += sample.nanoseconds;
+			allocations += sample.allocations;
+			bench::sink = static_cast<Int64>(level.tiles.size() + level.spawns.size());
+		}
+
+		report.add("json", name, "load_level", bytes, runs, { nanoseconds, allocations }, { { "file_bytes", bytes }, { "peak_heap_bytes", heap } });
+	}
+
+	// Sprites and level scripts asking for the same few documents over and
+	// over: every request reads and parses the file again, against one
+	// ResourceCache that parses each file once. Also checks the cache's
+	// size estimate against the heap the resident documents really hold.
+	void bench_resource_cache(bench::Report& report, const resource::Folder& data, Size requests)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		if (files.empty())
+			return;
+
+		resource::JsonCache::disable();
+		const auto file_of = [&files](Offset request) -> const Path& { return files[(request * 7) % files.size()]; };
+
+		report.add("json", "readJson", "shared_documents", requests, requests, bench::measure([&] {
+			for (Offset request = 0; request < requests; ++request)
+			{
+				Json json;
+				data.readJson(file_of(request), json);
+				bench::sink = static_cast<Int64>(json.size());
+			}
+		}), { { "files", files.size() } });
+
+		resource::ResourceCache cache{ data };
+		const Size before = bench::heap_live.load(std::memory_order_relaxed);
+		const bench::Sample sample = bench::measure([&] {
+			for (Offset request = 0; request < requests; ++request)
+				bench::sink = static_cast<Int64>(cache.json(file_of(request))->size());
+		});
+		const Size resident = bench::heap_live.load(std::memory_order_relaxed) - before;
+		const resource::ResourceCache::Stats stats = cache.stats();
+		report.add("json", "ResourceCache", "shared_documents", requests, requests, sample, {
+			{ "files", files.size() },
+			{ "hits", stats.hits },
+			{ "misses", stats.misses },
+			{ "estimated_bytes", stats.bytes },
+			{ "heap_bytes", resident }
+		});
+
+		report.add("json", "ResourceCache", "unload_unused", stats.entries, 1, bench::measure([&] {
+			bench::sink = static_cast<Int64>(cache.unloadUnused());
+		}));
+	}
+
+	// Reads the whole data tree as loose files and again from a pack of it,
+	// once through views (the bytes loadFromMemory would get) and once
+	// parsed by Folder::readJson.
+	void bench_pack(bench::Report& report, const resource::Folder& data, const Path& archive)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		Size bytes = 0;
+		for (const Path& file : files)
+			bytes += static_cast<Size>(std::filesystem::file_size(data.pathOf(file)));
+
+		resource::JsonCache::disable();
+		resource::Pack::unmount();
+
+		const bench::Sample sample = bench::measure([&] {
+			resource::PackWriter writer{ archive };
+			writer.addFolder(data.path());
+			writer.commit();
+		});
+		report.add("json", "PackWriter", "pack_tree", bytes, 1, sample, { { "files", files.size() }, { "archive_bytes", std::filesystem::file_size(archive) } });
+
+		const auto view_all = [&] {
+			Size total = 0;
+			resource::FileView view;
+			for (const Path& file : files)
+			{
+				data.openView(file, view);
+				total += static_cast<Size>(view.data.back());
+			}
+			bench::sink = static_cast<Int64>(total);
+		};
+		const auto read_all = [&] {
+			Json json;
+			for (const Path& file : files)
+			{
+				data.readJson(file, json);
+				bench::sink = static_cast<Int64>(json.size());
+			}
+		};
+
+		report.add("json", "loose", "view_tree", bytes, files.size(), bench::measure(view_all), { { "files", files.size() } });
+		report.add("json", "loose", "read_tree", bytes, files.size(), bench::measure(read_all), { { "files", files.size() } });
+
+		resource::Pack::mount(archive, data.path());
+		report.add("json", "pack", "view_tree", bytes, files.size(), bench::measure(view_all), { { "files", files.size() } });
+		report.add("json", "pack", "read_tree", bytes, files.size(), bench::measure(read_all), { { "files", files.size() } });
+		resource::Pack::unmount();
+	}
+
+	// A level transition: every document of the data tree is requested at
+	// once, then 60 Hz frames run until all of them are in. The interesting
+	// number is the longest time the main thread spent on loading in any
+	// one frame; with get() that is the whole load.
+	void bench_async(bench::Report& report, const resource::Folder& data)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		if (files.empty())
+			return;
+
+		resource::JsonCache::disable();
+		const auto frame = std::chrono::microseconds{ 16'667 };
+		const auto to_us = [](bench::Clock::duration duration) { return static_cast<Size>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count()); };
+
+		{
+			resource::ResourceCache cache{ data };
+			const bench::Sample sample = bench::measure([&] {
+				for (const Path& file : files)
+					bench::sink = static_cast<Int64>(cache.json(file)->size());
+			});
+			report.add("json", "ResourceCache::get", "level_transition", files.size(), files.size(), sample, {
+				{ "max_frame_us", static_cast<Size>(sample.nanoseconds / 1000) },
+				{ "frames", 1 }
+			});
+		}
+
+		{
+			resource::ResourceCache cache{ data };
+			resource::AsyncLoader loader;
+			std::vector<resource::LoadFuture<Json>> loads;
+			bench::Clock::duration longest{};
+			Size frames = 0;
+
+			const bench::Sample sample = bench::measure([&] {
+				for (auto next = bench::Clock::now();; next += frame)
+				{
+					const auto frame_start = bench::Clock::now();
+					if (frames++ == 0)
+					{
+						for (const Path& file : files)
+							loads.push_back(cache.getAsync<Json>(file, loader));
+					}
+					loader.update();
+					const bool done = std::all_of(loads.begin(), loads.end(), [](const auto& load) { return load.ready(); });
+					longest = std::max(longest, bench::Clock::now() - frame_start);
+					if (done)
+						break;
+					std::this_thread::sleep_until(next + frame);
+				}
+			});
+			report.add("json", "ResourceCache::getAsync", "level_transition", files.size(), files.size(), sample, {
+				{ "max_frame_us", to_us(longest) },
+				{ "frames", frames },
+				{ "workers", utils::ThreadPool::shared().size() }
+			});
+		}
+	}
+
+	// Edits 1 and 10 files of a resident data tree and times the path from
+	// the last write to the new contents being swapped in, with frames
+	// polling every millisecond and a 20 ms debounce; reload_all is what a
+	// change costs when everything is reloaded instead.
+	void bench_hot_reload(bench::Report& report, const resource::Folder& data)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		if (files.empty())
+			return;
+
+		resource::JsonCache::disable();
+		const std::chrono::milliseconds debounce{ 20 };
+
+		resource::ResourceCache cache{ data };
+		for (const Path& file : files)
+			cache.json(file);
+
+		Size directories = 0;
+		const bench::Sample setup = bench::measure([&] {
+			resource::FileWatcher watcher{ data };
+			directories = watcher.directories();
+		});
+		report.add("json", "FileWatcher", "watch_tree", files.size(), 1, setup, { { "directories", directories } });
+
+		resource::AsyncLoader loader;
+		resource::HotReloader<Json> reloader{ cache, loader, debounce };
+		if (!reloader.is_open())
+			return;
+
+		for (const Size changed : { Size{ 1 }, Size{ 10 } })
+		{
+			std::vector<Json> contents;
+			for (Offset i = 0; i < changed; ++i)
+				contents.push_back(*cache.json(files[i * files.size() / changed]));
+
+			const Size before = cache.stats().reloads;
+			const bench::Sample sample = bench::measure([&] {
+				for (Offset i = 0; i < changed; ++i)
+					data.writeJson(files[i * files.size() / changed], contents[i]);
+				while (cache.stats().reloads - before < changed)
+				{
+					reloader.update();
+					std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+				}
+			});
+			report.add("json", "HotReloader", "reload_" + std::to_string(changed) + "_of_" + std::to_string(files.size()), changed, 1, sample, {
+				{ "debounce_ms", static_cast<Size>(debounce.count()) }
+			});
+		}
+
+		report.add("json", "ResourceCache::reload", "reload_all", files.size(), 1, bench::measure([&] {
+			for (const Path& file : files)
+				cache.reload<Json>(file, loader);
+			loader.wait();
+			cache.applyReloads();
+		}));
+	}
+	// The data tree under two overlays, one replacing every tenth file and
+	// one, a mod, replacing a single file. probe opens each file in the
+	// topmost layer that has it by trying the layers in turn, as Folder
+	// would have to without an index; VirtualFolder resolves it from the
+	// index built by mount. missing reads files no layer holds.
+	void bench_virtual_folder(bench::Report& report, const resource::Folder& data)
+	{
+		const std::vector<Path> files = collect_json_files(data.path());
+		if (files.empty())
+			return;
+
+		resource::JsonCache::disable();
+		resource::Pack::unmount();
+
+		const Path overlay = data.path().parent_path() / "overlay";
+		const Path mod = data.path().parent_path() / "mod";
+		std::filesystem::remove_all(overlay);
+		std::filesystem::remove_all(mod);
+		for (Offset i = 0; i < files.size(); i += 10)
+		{
+			std::filesystem::create_directories((overlay / files[i]).parent_path());
+			std::filesystem::copy_file(data.pathOf(files[i]), overlay / files[i]);
+		}
+		std::filesystem::create_directories((mod / files.back()).parent_path());
+		std::filesystem::copy_file(data.pathOf(files.back()), mod / files.back());
+
+		const auto layered = [&] {
+			resource::VirtualFolder folder{ data.path() };
+			folder.addFolder(data.path(), 0);
+			folder.addFolder(overlay, 1);
+			folder.addFolder(mod, 2);
+			return folder;
+		};
+		const std::vector<resource::Folder> layers = { resource::Folder{ mod }, resource::Folder{ overlay }, data };
+
+		std::vector<Path> missing;
+		for (const Path& file : files)
+			missing.push_back(file.parent_path() / ("missing_" + file.filename().string()));
+
+		const auto probe = [&](const std::vector<Path>& paths) {
+			Size total = 0;
+			resource::FileView view;
+			for (const Path& file : paths)
+			{
+				for (const resource::Folder& layer : layers)
+				{
+					if (layer.openView(file, view))
+					{
+						total += view.data.size();
+						break;
+					}
+				}
+			}
+			bench::sink = static_cast<Int64>(total);
+		};
+		const auto resolve = [&](const std::vector<Path>& paths) {
+			Size total = 0;
+			resource::FileView view;
+			for (const Path& file : paths)
+			{
+				if (data.openView(file, view))
+					total += view.data.size();
+			}
+			bench::sink = static_cast<Int64>(total);
+		};
+
+		Size indexed = 0;
+		const bench::Sample mount = bench::measure([&] {
+			resource::VirtualFolder folder = layered();
+			indexed = folder.build();
+		});
+		report.add("json", "VirtualFolder", "mount_3_layers", indexed, 1, mount, { { "files", indexed } });
+
+		report.add("json", "probe", "view_tree", files.size(), files.size(), bench::measure([&] { probe(files); }), { { "layers", layers.size() } });
+		report.add("json", "probe", "missing", missing.size(), missing.size(), bench::measure([&] { probe(missing); }), { { "layers", layers.size() } });
+
+		resource::VirtualFolder::mount(layered());
+		report.add("json", "VirtualFolder", "view_tree", files.size(), files.size(), bench::measure([&] { resolve(files); }), { { "layers", layers.size() } });
+		report.add("json", "VirtualFolder", "missing", missing.size(), missing.size(), bench::measure([&] { resolve(missing); }), { { "layers", layers.size() } });
+		resource::VirtualFolder::unmount();
+
+		std::filesystem::remove_all(overlay);
+		std::filesystem::remove_all(mod);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// json_bench [output.json] [--quick] [data directory to time instead of a generated tree]
+	const Path output = argc > 1 ? Path{ argv[1] } : Path{ "json_bench.json" };
+	const bool quick = argc > 2 && String{ argv[2] } == "--quick";
+
+	const Path dir = std::filesystem::temp_directory_path() / "pacman_json_bench";
+	std::filesystem::create_directories(dir);
+	const resource::Folder folder = dir;
+
+	const String filename = "level.json";
+	const Size runs = quick ? 2 : 5;
+	Level level = make_level(quick ? 256 : 1024, quick ? 2'000 : 20'000);
+	folder.extractAndWrite(filename, level);
+	const Size bytes = static_cast<Size>(std::filesystem::file_size(folder.pathOf(filename)));
+
+	bench::Report report;
+	bench_load(report, "dom", folder, filename, bytes, runs, [](const resource::Folder& folder, const String& filename, Level& level) {
+		Json json;
+		folder.readJson(filename, json);
+		level.deserialize(json);
+	});
+	bench_load(report, "sax", folder, filename, bytes, runs, [](const resource::Folder& folder, const String& filename, Level& level) {
+		folder.readAndInject(filename, level);
+	});
+
+	bench_reflected(report, folder, filename, level, bytes, runs);
+
+	bench_arena(report, folder.pathOf(filename), "level", runs);
+
+	bench_flat(report, folder, quick ? 10'000 : 100'000, runs);
+	bench_keys(report, folder.pathOf("records.json"), quick ? 10'000 : 100'000, runs);
+
+	bench_intern(report, folder, quick ? 10 * 1024 * 1024 : 100 * 1024 * 1024);
+
+	bench_read_modes(report, folder, "small.json", 1024, quick ? 1'000 : 10'000);
+	bench_read_modes(report, folder, "large.json", quick ? 1024 * 1024 : 50 * 1024 * 1024, quick ? 2 : 3);
+	bench_lazy(report, folder, "large.json", quick ? 2 : 3);
+
+	bench_lines(report, folder, quick ? 100'000 : 1'000'000);
+
+	bench_save(report, folder, quick ? 1024 * 1024 : 10 * 1024 * 1024, quick ? 3 : 10);
+
+	const resource::Folder data = argc > 3 ? resource::Folder{ Path{ argv[3] } } : folder.folder("data");
+	if (argc <= 3)
+		make_data_tree(data, quick ? 24 : 200);
+	bench_data_tree(report, data, dir / "cache");
+	bench_resource_cache(report, data, quick ? 200 : 2'000);
+	bench_pack(report, data, dir / "data.pak");
+	bench_async(report, data);
+	bench_hot_reload(report, data);
+	bench_virtual_folder(report, data);
+
+	std::filesystem::remove_all(dir);
+	report.write(output);
+	return 0;
+}
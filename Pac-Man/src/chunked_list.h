@@ -0,0 +1,520 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	template<typename _Ty>
+	constexpr Size chunked_list_block_size = std::max<Size>(8, (8 * cache_line_size) / sizeof(_Ty));
+
+	template<typename _Ty, Size _BlockSize = chunked_list_block_size<_Ty>>
+	class ChunkedList
+	{
+		static_assert(_BlockSize >= 2, "ChunkedList blocks must hold at least two elements");
+
+	public:
+		class iterator;
+		class const_iterator;
+
+		static constexpr Size block_size = _BlockSize;
+
+	private:
+		struct alignas(std::max(alignof(_Ty), cache_line_size)) Block
+		{
+			alignas(_Ty) Byte storage[sizeof(_Ty) * _BlockSize];
+
+			inline _Ty* data() { return std::launder(reinterpret_cast<_Ty*>(storage)); }
+			inline const _Ty* data() const { return std::launder(reinterpret_cast<const _Ty*>(storage)); }
+
+			inline bool owns(const _Ty* ptr) const { return ptr >= data() && ptr < data() + _BlockSize; }
+		};
+
+		struct Entry
+		{
+			Block* block;
+			Size count;
+
+			inline _Ty& at(Offset index) { return block->data()[index]; }
+			inline const _Ty& at(Offset index) const { return block->data()[index]; }
+		};
+
+	public:
+		class iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			Entry* _entry;
+			Entry* _end;
+			Offset _index;
+
+		public:
+			iterator() : _entry{ nullptr }, _end{ nullptr }, _index{ 0 } {}
+			iterator(Entry* entry, Entry* end, Offset index = 0) : _entry{ entry }, _end{ end }, _index{ index } {}
+			iterator(const iterator&) = default;
+			iterator(iterator&&) noexcept = default;
+			~iterator() = default;
+
+			iterator& operator= (const iterator&) = default;
+			iterator& operator= (iterator&&) noexcept = default;
+
+			bool operator== (const iterator& right) const { return _entry == right._entry && _index == right._index; }
+
+			operator bool() const { return _entry != _end; }
+			bool operator! () const { return _entry == _end; }
+
+			iterator& operator++ ()
+			{
+				if (_entry != _end && ++_index >= _entry->count)
+					++_entry, _index = 0;
+				return *this;
+			}
+			iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			iterator operator+ (Offset offset) const
+			{
+				iterator it{ *this };
+				offset += it._index;
+				while (it._entry != it._end && offset >= it._entry->count)
+					offset -= it._entry->count, ++it._entry;
+				it._index = it._entry != it._end ? offset : 0;
+				return it;
+			}
+
+			reference operator* () const { return _entry->at(_index); }
+
+			pointer operator-> () const { return &_entry->at(_index); }
+
+			friend class ChunkedList;
+			friend class const_iterator;
+		};
+
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			const Entry* _entry;
+			const Entry* _end;
+			Offset _index;
+
+		public:
+			const_iterator() : _entry{ nullptr }, _end{ nullptr }, _index{ 0 } {}
+			const_iterator(const Entry* entry, const Entry* end, Offset index = 0) : _entry{ entry }, _end{ end }, _index{ index } {}
+			const_iterator(const iterator& it) : _entry{ it._entry }, _end{ it._end }, _index{ it._index } {}
+			const_iterator(const const_iterator&) = default;
+			const_iterator(const_iterator&&) noexcept = default;
+			~const_iterator() = default;
+
+			const_iterator& operator= (const iterator& right) { return _entry = right._entry, _end = right._end, _index = right._index, *this; };
+			const_iterator& operator= (const const_iterator&) = default;
+			const_iterator& operator= (const_iterator&&) noexcept = default;
+
+			bool operator== (const const_iterator& right) const { return _entry == right._entry && _index == right._index; }
+
+			operator bool() const { return _entry != _end; }
+			bool operator! () const { return _entry == _end; }
+
+			const_iterator& operator++ ()
+			{
+				if (_entry != _end && ++_index >= _entry->count)
+					++_entry, _index = 0;
+				return *this;
+			}
+			const_iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			const_iterator operator+ (Offset offset) const
+			{
+				const_iterator it{ *this };
+				offset += it._index;
+				while (it._entry != it._end && offset >= it._entry->count)
+					offset -= it._entry->count, ++it._entry;
+				it._index = it._entry != it._end ? offset : 0;
+				return it;
+			}
+
+			const_reference operator* () const { return _entry->at(_index); }
+
+			const_pointer operator-> () const { return &_entry->at(_index); }
+
+			friend class ChunkedList;
+			friend class iterator;
+		};
+
+		inline iterator begin() { return _iterator(0, 0); }
+		inline const_iterator begin() const { return _const_iterator(0, 0); }
+		inline const_iterator cbegin() const { return _const_iterator(0, 0); }
+
+		inline iterator end() { return _iterator(_blocks.size(), 0); }
+		inline const_iterator end() const { return _const_iterator(_blocks.size(), 0); }
+		inline const_iterator cend() const { return _const_iterator(_blocks.size(), 0); }
+
+	private:
+		std::vector<Entry> _blocks;
+		Size _size = 0;
+
+	private:
+		inline iterator _iterator(Offset block, Offset index) const
+		{
+			Entry* entries = const_cast<Entry*>(_blocks.data());
+			return { entries + block, entries + _blocks.size(), index };
+		}
+		inline const_iterator _const_iterator(Offset block, Offset index) const
+		{
+			return { _blocks.data() + block, _blocks.data() + _blocks.size(), index };
+		}
+
+		inline Offset _block_of(const iterator& it) const { return static_cast<Offset>(it._entry - _blocks.data()); }
+
+		Offset _locate(Offset& index) const
+		{
+			Offset block = 0;
+			for (const Size count = _blocks.size(); block < count && index >= _blocks[block].count; ++block)
+				index -= _blocks[block].count;
+			return block;
+		}
+
+		Offset _index_of(Offset block, Offset index) const
+		{
+			for (Offset i = 0; i < block; ++i)
+				index += _blocks[i].count;
+			return index;
+		}
+
+		void _new_block(Offset block)
+		{
+			Block* storage = new Block;
+			try { _blocks.insert(_blocks.begin() + block, Entry{ storage, 0 }); }
+			catch (...) { delete storage; throw; }
+		}
+
+		void _delete_block(Offset block)
+		{
+			Entry& entry = _blocks[block];
+			std::destroy_n(entry.block->data(), entry.count);
+			delete entry.block;
+			_blocks.erase(_blocks.begin() + block);
+		}
+
+		void _split(Offset block)
+		{
+			_new_block(block + 1);
+
+			Entry& left = _blocks[block];
+			Entry& right = _blocks[block + 1];
+			const Size half = left.count / 2;
+			const Size moved = left.count - half;
+
+			std::uninitialized_move_n(left.block->data() + half, moved, right.block->data());
+			std::destroy_n(left.block->data() + half, moved);
+			left.count = half;
+			right.count = moved;
+		}
+
+		void _try_merge(Offset block)
+		{
+			if (block + 1 >= _blocks.size())
+				return;
+
+			Entry& left = _blocks[block];
+			Entry& right = _blocks[block + 1];
+			if (left.count + right.count > _BlockSize / 2)
+				return;
+
+			std::uninitialized_move_n(right.block->data(), right.count, left.block->data() + left.count);
+			left.count += right.count;
+			_delete_block(block + 1);
+		}
+
+		template<typename... _Args>
+		iterator _emplace(Offset block, Offset index, _Args&&... args)
+		{
+			if (block >= _blocks.size())
+				_new_block(block = _blocks.size()), index = 0;
+			else if (_blocks[block].count >= _BlockSize)
+			{
+				_split(block);
+				if (index > _blocks[block].count)
+					index -= _blocks[block].count, ++block;
+			}
+
+			Entry& entry = _blocks[block];
+			_Ty* data = entry.block->data();
+			if (index == entry.count)
+				new (data + index) _Ty{ std::forward<_Args>(args)... };
+			else
+			{
+				_Ty value{ std::forward<_Args>(args)... };
+				new (data + entry.count) _Ty{ std::move(data[entry.count - 1]) };
+				std::move_backward(data + index, data + entry.count - 1, data + entry.count);
+				data[index] = std::move(value);
+			}
+
+			return ++entry.count, ++_size, _iterator(block, index);
+		}
+
+		template<typename... _Args>
+		iterator _emplace_at(Offset index, _Args&&... args)
+		{
+			if (index >= _size)
+			{
+				if (_blocks.empty() || _blocks.back().count >= _BlockSize)
+					return _emplace(_blocks.size(), 0, std::forward<_Args>(args)...);
+				return _emplace(_blocks.size() - 1, _blocks.back().count, std::forward<_Args>(args)...);
+			}
+
+			const Offset block = _locate(index);
+			return _emplace(block, index, std::forward<_Args>(args)...);
+		}
+
+		template<typename... _Args>
+		iterator _emplace_after(const iterator& it, _Args&&... args)
+		{
+			if (!it)
+				return _emplace_at(_size, std::forward<_Args>(args)...);
+
+			return _emplace(_block_of(it), it._index + 1, std::forward<_Args>(args)...);
+		}
+
+		iterator _erase(Offset block, Offset index)
+		{
+			Entry& entry = _blocks[block];
+			_Ty* data = entry.block->data();
+
+			std::move(data + index + 1, data + entry.count, data + index);
+			std::destroy_at(data + entry.count - 1);
+			--entry.count, --_size;
+
+			if (entry.count == 0)
+			{
+				_delete_block(block);
+				return _iterator(block, 0);
+			}
+
+			if (block > 0 && _blocks[block - 1].count + entry.count <= _BlockSize / 2)
+			{
+				index += _blocks[block - 1].count;
+				_try_merge(--block);
+			}
+			else _try_merge(block);
+
+			if (index >= _blocks[block].count)
+				return _iterator(block + 1, 0);
+			return _iterator(block, index);
+		}
+
+		void _destroy()
+		{
+			for (Entry& entry : _blocks)
+			{
+				std::destroy_n(entry.block->data(), entry.count);
+				delete entry.block;
+			}
+
+			_blocks.clear();
+			_size = 0;
+		}
+
+		ChunkedList& _copy(const ChunkedList& list, bool reset)
+		{
+			if (reset)
+				_destroy();
+
+			_blocks.reserve(list._blocks.size());
+			for (const Entry& entry : list._blocks)
+			{
+				_new_block(_blocks.size());
+				std::uninitialized_copy_n(entry.block->data(), entry.count, _blocks.back().block->data());
+				_blocks.back().count = entry.count;
+				_size += entry.count;
+			}
+
+			return *this;
+		}
+
+		ChunkedList& _move(ChunkedList&& list, bool reset) noexcept
+		{
+			if (reset)
+				_destroy();
+
+			_blocks = std::move(list._blocks);
+			_size = list._size;
+
+			list._blocks.clear();
+			list._size = 0;
+
+			return *this;
+		}
+
+	public:
+		ChunkedList() = default;
+		ChunkedList(const ChunkedList& list) : ChunkedList{} { _copy(list, false); }
+		ChunkedList(ChunkedList&& list) noexcept : ChunkedList{} { _move(std::move(list), false); }
+		~ChunkedList() { _destroy(); }
+
+		ChunkedList& operator= (const ChunkedList& right) { return this == &right ? *this : _copy(right, true); }
+		ChunkedList& operator= (ChunkedList&& right) noexcept { return this == &right ? *this : _move(std::move(right), true); }
+
+		inline bool empty() const { return _size == 0; }
+		inline Size size() const { return _size; }
+		inline Size block_count() const { return _blocks.size(); }
+
+		inline operator bool() const { return _size > 0; }
+		inline bool operator! () const { return _size == 0; }
+
+		template<typename... _Args>
+		iterator emplace_back(_Args&&... args) { return _emplace_at(_size, std::forward<_Args>(args)...); }
+
+		template<typename... _Args>
+		iterator emplace_front(_Args&&... args) { return _emplace(0, 0, std::forward<_Args>(args)...); }
+
+		template<typename... _Args>
+		iterator emplace(Offset index, _Args&&... args) { return _emplace_at(index, std::forward<_Args>(args)...); }
+
+		template<typename... _Args>
+		iterator emplace(const iterator& it, _Args&&... args) { return _emplace_after(it, std::forward<_Args>(args)...); }
+
+		iterator push_back(const _Ty& elem) { return _emplace_at(_size, elem); }
+		iterator push_back(_Ty&& elem) { return _emplace_at(_size, std::move(elem)); }
+
+		iterator push_front(const _Ty& elem) { return _emplace(0, 0, elem); }
+		iterator push_front(_Ty&& elem) { return _emplace(0, 0, std::move(elem)); }
+
+		iterator insert(Offset index, const _Ty& elem) { return _emplace_at(index, elem); }
+		iterator insert(Offset index, _Ty&& elem) { return _emplace_at(index, std::move(elem)); }
+
+		iterator insert(const iterator& it, const _Ty& elem) { return _emplace_after(it, elem); }
+		iterator insert(const iterator& it, _Ty&& elem) { return _emplace_after(it, std::move(elem)); }
+
+		iterator get_iterator(const _Ty* elem_ptr) const
+		{
+			for (Offset block = 0; block < _blocks.size(); ++block)
+			{
+				const Entry& entry = _blocks[block];
+				if (entry.block->owns(elem_ptr))
+				{
+					const Offset index = static_cast<Offset>(elem_ptr - entry.block->data());
+					return index < entry.count ? _iterator(block, index) : _iterator(_blocks.size(), 0);
+				}
+			}
+			return _iterator(_blocks.size(), 0);
+		}
+
+		inline iterator get_iterator(const _Ty& elem) const { return get_iterator(&elem); }
+
+		iterator get_iterator(Offset index) const
+		{
+			if (index >= _size)
+				return _iterator(_blocks.size(), 0);
+
+			const Offset block = _locate(index);
+			return _iterator(block, index);
+		}
+
+		iterator erase(const iterator& it)
+		{
+			if (it)
+				return _erase(_block_of(it), it._index);
+			return end();
+		}
+
+		iterator erase(const iterator& from, const iterator& to)
+		{
+			if (!from)
+				return end();
+
+			const Offset first = _index_of(_block_of(from), from._index);
+			Size count = (to ? _index_of(_block_of(to), to._index) : _size) - first;
+
+			iterator it = from;
+			while (count-- > 0)
+				it = erase(it);
+			return it;
+		}
+
+		inline iterator erase(Offset index) { return erase(get_iterator(index)); }
+
+		inline iterator erase(const _Ty* elem_ptr) { return erase(get_iterator(elem_ptr)); }
+
+		inline iterator erase(const _Ty& elem) { return erase(get_iterator(elem)); }
+
+		inline void clear() { _destroy(); }
+
+		void clear(const Function<void(_Ty&)>& onDestroyAction)
+		{
+			for (Entry& entry : _blocks)
+				for (Offset i = 0; i < entry.count; ++i)
+					onDestroyAction(entry.at(i));
+			_destroy();
+		}
+
+		inline _Ty& at(Offset index) { return *get_iterator(index); }
+		inline const _Ty& at(Offset index) const { return *get_iterator(index); }
+
+		inline _Ty& front() { return _blocks.front().at(0); }
+		inline const _Ty& front() const { return _blocks.front().at(0); }
+
+		inline _Ty& back() { return _blocks.back().at(_blocks.back().count - 1); }
+		inline const _Ty& back() const { return _blocks.back().at(_blocks.back().count - 1); }
+
+		inline ChunkedList& operator<< (const _Ty& right) { return push_back(right), *this; }
+		inline ChunkedList& operator<< (_Ty&& right) { return push_back(std::move(right)), *this; }
+
+		ChunkedList& operator+= (const ChunkedList& right)
+		{
+			// Appending walks right's blocks, which push_back would move.
+			if (this == &right)
+				return *this += ChunkedList{ right };
+
+			for (const Entry& entry : right._blocks)
+				for (Offset i = 0; i < entry.count; ++i)
+					push_back(entry.at(i));
+			return *this;
+		}
+
+		ChunkedList& operator+= (ChunkedList&& right)
+		{
+			if (this == &right)
+				return *this;
+			if (_blocks.empty())
+				return _move(std::move(right), false);
+
+			_blocks.insert(_blocks.end(), right._blocks.begin(), right._blocks.end());
+			_size += right._size;
+
+			right._blocks.clear();
+			right._size = 0;
+
+			return *this;
+		}
+
+		ChunkedList operator+ (const ChunkedList& right) const
+		{
+			ChunkedList list = *this;
+			return list += right;
+		}
+
+		ChunkedList operator+ (ChunkedList&& right) const
+		{
+			ChunkedList list = *this;
+			return list += std::move(right);
+		}
+
+		inline _Ty& operator[] (Offset index) { return *get_iterator(index); }
+		inline const _Ty& operator[] (Offset index) const { return *get_iterator(index); }
+	};
+}
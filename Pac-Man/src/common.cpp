@@ -1,4 +1,286 @@
 #include "common.h"
+#include "thread_pool.h"
+#include "resource_pack.h"
+#include "resource_vfs.h"
+
+#include <cstring>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(MAP_POPULATE)
+static constexpr int map_populate = MAP_POPULATE;
+#else
+static constexpr int map_populate = 0;
+#endif
+
+namespace utils
+{
+	SlabPool::SlabPool(Size block_size, Size block_align, Size chunk_blocks) :
+		_block_size{ std::max(block_size, sizeof(FreeBlock)) },
+		_block_align{ std::max(block_align, alignof(FreeBlock)) },
+		_chunk_blocks{ std::max<Size>(chunk_blocks, 1) },
+		_chunks{}
+	{
+		_block_size = (_block_size + _block_align - 1) / _block_align * _block_align;
+	}
+
+	SlabPool::~SlabPool()
+	{
+		for (Byte* chunk : _chunks)
+			::operator delete(chunk, std::align_val_t{ _block_align });
+	}
+
+	void* SlabPool::allocate()
+	{
+		if (_free)
+		{
+			FreeBlock* block = _free;
+			_free = block->next;
+			return ++_used, block;
+		}
+
+		if (_cursor == _limit)
+			_grow();
+
+		Byte* block = _cursor;
+		_cursor += _block_size;
+		return ++_used, block;
+	}
+
+	void SlabPool::deallocate(void* ptr)
+	{
+		if (ptr)
+		{
+			FreeBlock* block = static_cast<FreeBlock*>(ptr);
+			block->next = _free;
+			_free = block;
+			--_used;
+		}
+	}
+
+	void SlabPool::_grow()
+	{
+		const Size blocks = _chunks.empty() ? _chunk_blocks : std::min(_capacity, max_chunk_blocks);
+
+		_chunks.push_back(nullptr);
+		Byte* chunk = static_cast<Byte*>(::operator new(blocks * _block_size, std::align_val_t{ _block_align }));
+		_chunks.back() = chunk;
+
+		_cursor = chunk;
+		_limit = chunk + blocks * _block_size;
+		_capacity += blocks;
+	}
+}
+
+namespace utils
+{
+	Arena::Arena(Size chunk_size) :
+		_chunks{},
+		_next_chunk_size{ std::max<Size>(chunk_size, 256) }
+	{}
+
+	Arena::~Arena()
+	{
+		for (const Chunk& chunk : _chunks)
+			::operator delete(chunk.data, std::align_val_t{ cache_line_size });
+	}
+
+	void Arena::reset()
+	{
+		_chunk = 0;
+		_cursor = _chunks.empty() ? nullptr : _chunks.front().data;
+		_limit = _chunks.empty() ? nullptr : _chunks.front().data + _chunks.front().size;
+		_used = 0;
+	}
+
+	Size Arena::capacity() const
+	{
+		Size capacity = 0;
+		for (const Chunk& chunk : _chunks)
+			capacity += chunk.size;
+		return capacity;
+	}
+
+	void* Arena::_grow(Size size, Size align)
+	{
+		const Size needed = size + align;
+
+		// Chunks kept from before a reset are reused in order; one that is
+		// too small for this request is skipped.
+		Offset next = _cursor ? _chunk + 1 : _chunk;
+		while (next < _chunks.size() && _chunks[next].size < needed)
+			++next;
+
+		if (next >= _chunks.size())
+		{
+			const Size chunk_size = std::max(_next_chunk_size, needed);
+			_chunks.push_back({ static_cast<Byte*>(::operator new(chunk_size, std::align_val_t{ cache_line_size })), chunk_size });
+			_next_chunk_size = std::min(_next_chunk_size * 2, max_chunk_size);
+			next = _chunks.size() - 1;
+		}
+
+		_chunk = next;
+		_cursor = _chunks[next].data;
+		_limit = _chunks[next].data + _chunks[next].size;
+		return allocate(size, align);
+	}
+}
+
+namespace utils
+{
+	MappedFile::MappedFile(MappedFile&& other) noexcept :
+		_data{ std::exchange(other._data, nullptr) },
+		_size{ std::exchange(other._size, 0) },
+		_mapped{ std::exchange(other._mapped, false) },
+		_open{ std::exchange(other._open, false) }
+	{}
+	MappedFile::~MappedFile() { close(); }
+
+	MappedFile::MappedFile(const Path& path) { open(path); }
+
+	MappedFile& MappedFile::operator= (MappedFile&& right) noexcept
+	{
+		if (this != &right)
+		{
+			close();
+			_data = std::exchange(right._data, nullptr);
+			_size = std::exchange(right._size, 0);
+			_mapped = std::exchange(right._mapped, false);
+			_open = std::exchange(right._open, false);
+		}
+		return *this;
+	}
+
+	bool MappedFile::open(const Path& path)
+	{
+		close();
+
+#if defined(_WIN32)
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size))
+			return CloseHandle(file), false;
+
+		if (size.QuadPart > 0 && static_cast<Size>(size.QuadPart) < map_threshold)
+		{
+			char* buffer = new char[static_cast<Size>(size.QuadPart)];
+			DWORD count = 0;
+			const BOOL ok = ReadFile(file, buffer, static_cast<DWORD>(size.QuadPart), &count, nullptr);
+			CloseHandle(file);
+			if (!ok)
+				return delete[] buffer, false;
+
+			_data = buffer;
+			_size = static_cast<Size>(count);
+			return _open = true;
+		}
+		else if (size.QuadPart > 0)
+		{
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (!mapping)
+				return false;
+
+			_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+			if (!_data)
+				return false;
+			_mapped = true;
+		}
+		else CloseHandle(file);
+
+		_size = static_cast<Size>(size.QuadPart);
+#elif defined(__unix__) || defined(__APPLE__)
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+			return ::close(fd), false;
+
+		if (info.st_size > 0 && static_cast<Size>(info.st_size) < map_threshold)
+		{
+			char* buffer = new char[static_cast<Size>(info.st_size)];
+			const ssize_t count = ::read(fd, buffer, static_cast<Size>(info.st_size));
+			::close(fd);
+			if (count < 0)
+				return delete[] buffer, false;
+
+			_data = buffer;
+			_size = static_cast<Size>(count);
+			return _open = true;
+		}
+		else if (info.st_size > 0)
+		{
+			void* data = mmap(nullptr, static_cast<Size>(info.st_size), PROT_READ, MAP_PRIVATE | map_populate, fd, 0);
+			::close(fd);
+			if (data == MAP_FAILED)
+				return false;
+
+			madvise(data, static_cast<Size>(info.st_size), MADV_SEQUENTIAL);
+			_data = static_cast<const char*>(data);
+			_mapped = true;
+		}
+		else ::close(fd);
+
+		_size = static_cast<Size>(info.st_size);
+#else
+		std::error_code error;
+		if (!filesystem::is_regular_file(path, error))
+			return false;
+
+		std::ifstream stream{ path, std::ios::in | std::ios::binary };
+		if (stream.fail())
+			return false;
+
+		_size = static_cast<Size>(filesystem::file_size(path, error));
+		if (_size > 0)
+		{
+			char* buffer = new char[_size];
+			stream.read(buffer, static_cast<std::streamsize>(_size));
+			_size = static_cast<Size>(stream.gcount());
+			_data = buffer;
+		}
+#endif
+
+		return _open = true;
+	}
+
+	void MappedFile::close()
+	{
+		if (_data)
+		{
+#if defined(_WIN32)
+			if (_mapped)
+				UnmapViewOfFile(_data);
+#elif defined(__unix__) || defined(__APPLE__)
+			if (_mapped)
+				munmap(const_cast<char*>(_data), _size);
+#endif
+			if (!_mapped)
+				delete[] _data;
+		}
+
+		_data = nullptr;
+		_size = 0;
+		_mapped = false;
+		_open = false;
+	}
+}
 
 namespace utils::json
 {
@@ -23,6 +305,95 @@ namespace utils::json
 		return read(f);
 	}
 
+	void read(std::istream& input, JsonSaxHandler& handler)
+	{
+		try
+		{
+			Json::sax_parse(input, &handler);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+	void read(const Path& path, JsonSaxHandler& handler)
+	{
+		std::fstream f{ path, std::ios::in };
+		read(f, handler);
+	}
+	void read(const String& path, JsonSaxHandler& handler)
+	{
+		std::fstream f{ path, std::ios::in };
+		read(f, handler);
+	}
+
+	Json read(const char* begin, const char* end)
+	{
+		try
+		{
+			return Json::parse(begin, end);
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+	void read(const char* begin, const char* end, JsonSaxHandler& handler)
+	{
+		try
+		{
+			Json::sax_parse(begin, end, &handler);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	Json read_mapped(const Path& path)
+	{
+		MappedFile file;
+		if (!file.open(path))
+			throw JsonException{ "cannot map " + path.string() };
+		return read(file);
+	}
+	void read_mapped(const Path& path, JsonSaxHandler& handler)
+	{
+		MappedFile file;
+		if (!file.open(path))
+			throw JsonException{ "cannot map " + path.string() };
+		read(file, handler);
+	}
+
+	std::vector<ReadResult> read_many(const std::vector<Path>& paths, Size threads)
+	{
+		std::vector<ReadResult> results(paths.size());
+		ThreadPool::run_batch(paths.size(), threads, [&paths, &results](Offset index) {
+			try { results[index].json = read_mapped(paths[index]); }
+			catch (const std::exception& ex) { results[index].error = ex.what(); }
+		});
+		return results;
+	}
+
+	std::vector<UInt8> to_binary(const Json& json, BinaryFormat format)
+	{
+		switch (format)
+		{
+			case BinaryFormat::Cbor: return Json::to_cbor(json);
+			case BinaryFormat::MessagePack: return Json::to_msgpack(json);
+			case BinaryFormat::Ubjson: return Json::to_ubjson(json);
+		}
+		throw JsonException{ "unknown binary json format" };
+	}
+
+	Json from_binary(const char* data, Size size, BinaryFormat format)
+	{
+		try
+		{
+			switch (format)
+			{
+				case BinaryFormat::Cbor: return Json::from_cbor(data, data + size);
+				case BinaryFormat::MessagePack: return Json::from_msgpack(data, data + size);
+				case BinaryFormat::Ubjson: return Json::from_ubjson(data, data + size);
+			}
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+		throw JsonException{ "unknown binary json format" };
+	}
+
 	void write(std::ostream& output, const Json& json)
 	{
 		try
@@ -43,6 +414,101 @@ namespace utils::json
 	}
 }
 
+namespace utils::json
+{
+	bool JsonSaxHandler::null() { return _value(nullptr); }
+	bool JsonSaxHandler::boolean(bool val) { return _value(val); }
+	bool JsonSaxHandler::number_integer(number_integer_t val) { return _value(val); }
+	bool JsonSaxHandler::number_unsigned(number_unsigned_t val) { return _value(val); }
+	bool JsonSaxHandler::number_float(number_float_t val, const string_t&) { return _value(val); }
+	bool JsonSaxHandler::string(string_t& val) { return _value(std::move(val)); }
+
+	bool JsonSaxHandler::start_object(std::size_t) { return _enter(false); }
+	bool JsonSaxHandler::key(string_t& val) { return _scopes.back().key = std::move(val), true; }
+	bool JsonSaxHandler::end_object() { return _leave(false); }
+
+	bool JsonSaxHandler::start_array(std::size_t) { return _enter(true); }
+	bool JsonSaxHandler::end_array() { return _leave(true); }
+
+	bool JsonSaxHandler::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+	{
+		throw JsonException{ ex.what() };
+	}
+
+	const String& JsonSaxHandler::key() const
+	{
+		static const String empty;
+		return _scopes.empty() || _scopes.back().array ? empty : _scopes.back().key;
+	}
+
+	bool JsonSaxHandler::_value(Json&& value)
+	{
+		if (!_captures.empty())
+		{
+			Json& parent = *_captures.back();
+			if (parent.is_array())
+				parent.push_back(std::move(value));
+			else parent[_scopes.back().key] = std::move(value);
+		}
+		else if (!this->value(std::move(value)))
+			return false;
+
+		if (!_scopes.empty())
+			++_scopes.back().index;
+		return true;
+	}
+
+	bool JsonSaxHandler::_enter(bool array)
+	{
+		Json container = array ? Json::array() : Json::object();
+		if (!_captures.empty())
+		{
+			Json& parent = *_captures.back();
+			if (parent.is_array())
+			{
+				parent.push_back(std::move(container));
+				_captures.push_back(&parent.back());
+			}
+			else _captures.push_back(&(parent[_scopes.back().key] = std::move(container)));
+		}
+		else
+		{
+			_capture = false;
+			if (!enter(array))
+				return false;
+			if (_capture)
+			{
+				_captured = std::move(container);
+				_captures.push_back(&_captured);
+			}
+		}
+
+		_scopes.push_back({ {}, 0, array });
+		return true;
+	}
+
+	bool JsonSaxHandler::_leave(bool array)
+	{
+		_scopes.pop_back();
+		if (!_captures.empty())
+		{
+			_captures.pop_back();
+			if (!_captures.empty())
+				return ++_scopes.back().index, true;
+
+			_capture = false;
+			if (!value(std::move(_captured)))
+				return false;
+		}
+		else if (!leave(array))
+			return false;
+
+		if (!_scopes.empty())
+			++_scopes.back().index;
+		return true;
+	}
+}
+
 std::ostream& operator<< (std::ostream& left, const utils::json::JsonSerializable& right) { return utils::json::write(left, right), left; }
 std::istream& operator>> (std::istream& left, utils::json::JsonSerializable& right) { return utils::json::read(left, right), left; }
 
@@ -53,6 +519,182 @@ std::istream& operator>> (std::istream& left, utils::json::JsonSerializable& rig
 
 namespace resource
 {
+	namespace
+	{
+		constexpr char cache_magic[4] = { 'P', 'J', 'C', '1' };
+
+		// magic, format, source size, source mtime, source path length, source path, payload
+		constexpr Size cache_header_size = sizeof(cache_magic) + sizeof(UInt8) + sizeof(UInt64) + sizeof(Int64) + sizeof(UInt32);
+
+		std::mutex active_cache_mutex;
+		std::shared_ptr<const JsonCache> active_cache;
+
+		const char* cache_extension(JsonCache::Format format)
+		{
+			switch (format)
+			{
+				case JsonCache::Format::Cbor: return ".cbor";
+				case JsonCache::Format::MessagePack: return ".msgpack";
+				case JsonCache::Format::Ubjson: return ".ubj";
+			}
+			return ".bin";
+		}
+	}
+
+	JsonCache::JsonCache(const Path& directory, Format format) :
+		_directory{ directory },
+		_format{ format }
+	{}
+
+	bool JsonCache::read(const Path& source, Json& json) const
+	{
+		std::error_code error;
+		if (!filesystem::is_regular_file(source, error))
+			return false;
+
+		const UInt64 size = static_cast<UInt64>(filesystem::file_size(source, error));
+		const Int64 mtime = static_cast<Int64>(filesystem::last_write_time(source, error).time_since_epoch().count());
+		if (error)
+			return false;
+
+		const String key = filesystem::absolute(source, error).lexically_normal().generic_string();
+		const Path entry = _entryOf(key);
+		if (_load(entry, key, size, mtime, json))
+			return true;
+
+		utils::MappedFile file;
+		if (!file.open(source))
+			return false;
+
+		json = utils::json::read(file);
+		_store(entry, key, size, mtime, json);
+		return true;
+	}
+
+	Path JsonCache::entryOf(const Path& source) const
+	{
+		std::error_code error;
+		return _entryOf(filesystem::absolute(source, error).lexically_normal().generic_string());
+	}
+
+	Path JsonCache::_entryOf(const String& key) const
+	{
+		char name[17];
+		std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(std::hash<String>{}(key)));
+		return _directory / (String{ name } + cache_extension(_format));
+	}
+
+	void JsonCache::clear() const
+	{
+		std::error_code error;
+		filesystem::remove_all(_directory, error);
+	}
+
+	bool JsonCache::_load(const Path& entry, const String& source, UInt64 size, Int64 mtime, Json& json) const
+	{
+		utils::MappedFile file;
+		if (!file.open(entry) || file.size() < cache_header_size)
+			return false;
+
+		const char* ptr = file.data();
+		const auto next = [&ptr]<typename _Ty>(_Ty& value) { std::memcpy(&value, ptr, sizeof(_Ty)); ptr += sizeof(_Ty); };
+
+		char magic[sizeof(cache_magic)];
+		UInt8 entry_format;
+		UInt64 entry_size;
+		Int64 entry_mtime;
+		UInt32 source_length;
+		next(magic), next(entry_format), next(entry_size), next(entry_mtime), next(source_length);
+
+		if (std::memcmp(magic, cache_magic, sizeof(cache_magic)) != 0 ||
+			entry_format != static_cast<UInt8>(_format) ||
+			entry_size != size ||
+			entry_mtime != mtime ||
+			source_length != source.size() ||
+			file.size() < cache_header_size + source.size() ||
+			source.compare(0, source.size(), ptr, source_length) != 0)
+			return false;
+
+		ptr += source_length;
+		try
+		{
+			json = utils::json::from_binary(ptr, static_cast<Size>(file.end() - ptr), _format);
+			return true;
+		}
+		catch (const utils::json::JsonException&) { return false; }
+	}
+
+	void JsonCache::_store(const Path& entry, const String& source, UInt64 size, Int64 mtime, const Json& json) const
+	{
+		const std::vector<UInt8> payload = utils::json::to_binary(json, _format);
+		const UInt8 format = static_cast<UInt8>(_format);
+		const UInt32 source_length = static_cast<UInt32>(source.size());
+
+		std::error_code error;
+		filesystem::create_directories(_directory, error);
+
+		// Written under a unique name and renamed into place, so concurrent
+		// readers never see a partial entry.
+		const Path temp = utils::temp_path(entry);
+		{
+			std::ofstream output{ temp, std::ios::out | std::ios::binary | std::ios::trunc };
+			if (output.fail())
+				return;
+
+			output.write(cache_magic, sizeof(cache_magic));
+			output.write(reinterpret_cast<const char*>(&format), sizeof(format));
+			output.write(reinterpret_cast<const char*>(&size), sizeof(size));
+			output.write(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+			output.write(reinterpret_cast<const char*>(&source_length), sizeof(source_length));
+			output.write(source.data(), static_cast<std::streamsize>(source.size()));
+			output.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+		}
+
+		if (filesystem::file_size(temp, error) != cache_header_size + source.size() + payload.size())
+		{
+			filesystem::remove(temp, error);
+			return;
+		}
+
+		filesystem::rename(temp, entry, error);
+		if (error)
+			filesystem::remove(temp, error);
+	}
+
+	void JsonCache::enable(const Path& directory, Format format)
+	{
+		std::lock_guard lock{ active_cache_mutex };
+		active_cache = std::make_shared<const JsonCache>(directory, format);
+	}
+
+	void JsonCache::disable()
+	{
+		std::lock_guard lock{ active_cache_mutex };
+		active_cache.reset();
+	}
+
+	std::shared_ptr<const JsonCache> JsonCache::active()
+	{
+		std::lock_guard lock{ active_cache_mutex };
+		return active_cache;
+	}
+
+
+
+	namespace
+	{
+		// Input over memory that is read in place.
+		class ViewStreamBuffer : public std::streambuf
+		{
+		public:
+			explicit ViewStreamBuffer(std::string_view data)
+			{
+				char* begin = const_cast<char*>(data.data());
+				setg(begin, begin, begin + data.size());
+			}
+		};
+	}
+
 	Folder::Folder(const Path& path) :
 		_path{ path }
 	{}
@@ -60,40 +702,66 @@ namespace resource
 		_path{ parent._path / path }
 	{}
 
-	bool Folder::_open(const String& filename, std::ifstream& stream) const
+	bool Folder::_locate(const Path& path, FileView& view, Path& file) const
 	{
-		stream.open(_path / filename, std::ios::in);
-		return !stream.fail();
+		String name;
+		if (const auto folder = VirtualFolder::mounted(); folder && folder->relative(_path / path, name))
+			return folder->find(name, view, file);
+
+		std::string_view data;
+		if (const auto pack = Pack::mounted(); pack && pack->relative(_path / path, name) && pack->find(name, data))
+		{
+			view.owner = pack->owner();
+			view.data = data;
+			file.clear();
+			return true;
+		}
+
+		file = _path / path;
+		return true;
 	}
+
+	bool Folder::_open(const String& filename, std::ifstream& stream) const { return _open(Path{ filename }, stream); }
 	bool Folder::_open(const Path& path, std::ifstream& stream) const
 	{
-		stream.open(_path / path, std::ios::in);
-		return !stream.fail();
-	}
-	bool Folder::_open(const String& filename, std::ofstream& stream) const
-	{
-		stream.open(_path / filename, std::ios::out);
+		FileView view;
+		Path file;
+		if (!_locate(path, view, file))
+			return false;
+
+		stream.open(file.empty() ? _path / path : file, std::ios::in);
 		return !stream.fail();
 	}
+	bool Folder::_open(const String& filename, std::ofstream& stream) const { return _open(Path{ filename }, stream); }
 	bool Folder::_open(const Path& path, std::ofstream& stream) const
 	{
 		stream.open(_path / path, std::ios::out);
-		return !stream.fail();
+		if (stream.fail())
+			return false;
+
+		VirtualFolder::written(_path / path);
+		return true;
 	}
 
 	bool Folder::openInput(const String& filename, std::ifstream& input) const { return _open(filename, input); }
 	bool Folder::openInput(const Path& path, std::ifstream& input) const { return _open(path, input); }
-	bool Folder::openInput(const String& filename, const Function<void(std::istream&)>& action) const
-	{
-		std::ifstream stream;
-		if (_open(filename, stream))
-			return action(stream), true;
-		return false;
-	}
+	bool Folder::openInput(const String& filename, const Function<void(std::istream&)>& action) const { return openInput(Path{ filename }, action); }
 	bool Folder::openInput(const Path& path, const Function<void(std::istream&)>& action) const
 	{
-		std::ifstream stream;
-		if (_open(path, stream))
+		FileView view;
+		Path file;
+		if (!_locate(path, view, file))
+			return false;
+
+		if (file.empty())
+		{
+			ViewStreamBuffer buffer{ view.data };
+			std::istream stream{ &buffer };
+			return action(stream), true;
+		}
+
+		std::ifstream stream{ file, std::ios::in };
+		if (!stream.fail())
 			return action(stream), true;
 		return false;
 	}
@@ -115,8 +783,57 @@ namespace resource
 		return false;
 	}
 
-	bool Folder::readJson(const String& filename, Json& json) const { return openInput(filename, [&json](std::istream& is) { json = utils::json::read(is); }); }
-	bool Folder::readJson(const Path& path, Json& json) const { return openInput(path, [&json](std::istream& is) { json = utils::json::read(is); }); }
+	bool Folder::readJson(const String& filename, Json& json) const { return readJson(Path{ filename }, json); }
+	bool Folder::readJson(const Path& path, Json& json) const
+	{
+		FileView view;
+		Path file;
+		if (!_locate(path, view, file))
+			return false;
+
+		if (file.empty())
+			return json = utils::json::read(view.data.data(), view.data.data() + view.data.size()), true;
+
+		if (const auto cache = JsonCache::active(); cache && cache->read(file, json))
+			return true;
+
+		utils::MappedFile mapped;
+		if (mapped.open(file))
+			return json = utils::json::read(mapped), true;
+		return openInput(path, [&json](std::istream& is) { json = utils::json::read(is); });
+	}
+
+	bool Folder::openView(const String& filename, FileView& view) const { return openView(Path{ filename }, view); }
+	bool Folder::openView(const Path& path, FileView& view) const
+	{
+		Path file;
+		if (!_locate(path, view, file))
+			return false;
+		if (file.empty())
+			return true;
+
+		const auto mapped = std::make_shared<utils::MappedFile>();
+		if (!mapped->open(file))
+			return false;
+
+		view.data = { mapped->data(), mapped->size() };
+		view.owner = mapped;
+		return true;
+	}
+
+	std::vector<utils::json::ReadResult> Folder::readJsonBatch(const std::vector<Path>& paths, Size threads) const
+	{
+		std::vector<utils::json::ReadResult> results(paths.size());
+		utils::ThreadPool::run_batch(paths.size(), threads, [this, &paths, &results](Offset index) {
+			try
+			{
+				if (!readJson(paths[index], results[index].json))
+					results[index].error = "cannot open " + pathOf(paths[index]).string();
+			}
+			catch (const std::exception& ex) { results[index].error = ex.what(); }
+		});
+		return results;
+	}
 
 	bool Folder::writeJson(const String& filename, const Json& json) const { return openOutput(filename, [&json](std::ostream& os) { utils::json::write(os, json); }); }
 	bool Folder::writeJson(const Path& path, const Json& json) const { return openOutput(path, [&json](std::ostream& os) { utils::json::write(os, json); }); }
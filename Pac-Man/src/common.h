@@ -2,21 +2,27 @@
 
 #include <unordered_map>
 #include <type_traits>
+#include <string_view>
 #include <functional>
 #include <filesystem>
 #include <algorithm>
 #include <exception>
+#include <stdexcept>
 #include <iostream>
 #include <iterator>
 #include <sstream>
 #include <fstream>
 #include <compare>
+#include <cstring>
 #include <utility>
 #include <chrono>
+#include <atomic>
+#include <thread>
 #include <random>
 #include <memory>
 #include <vector>
 #include <string>
+#include <mutex>
 #include <queue>
 #include <cmath>
 #include <list>
@@ -72,7 +78,7 @@ inline Path operator"" _p(const char* str, Size size) { return { String{ str, si
 namespace utils
 {
 	template<typename _Ty = void>
-	inline _Ty* malloc(Size size) { reinterpret_cast<_Ty*>(::operator new(size)); }
+	inline _Ty* malloc(Size size) { return reinterpret_cast<_Ty*>(::operator new(size)); }
 
 	inline void free(void* ptr) { ::operator delete(ptr); }
 
@@ -152,13 +158,60 @@ namespace utils
 
 
 
+namespace utils
+{
+	// Read-only view of a whole regular file. Files of map_threshold bytes or
+	// more are mapped into memory where the platform allows it; smaller ones
+	// (and every file elsewhere) are read into a private buffer in one call,
+	// which is cheaper than setting up a mapping.
+	class MappedFile
+	{
+	public:
+		static constexpr Size map_threshold = 64 * 1024;
+
+	private:
+		const char* _data = nullptr;
+		Size _size = 0;
+		bool _mapped = false;
+		bool _open = false;
+
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		explicit MappedFile(const Path& path);
+
+		MappedFile& operator= (const MappedFile&) = delete;
+		MappedFile& operator= (MappedFile&& right) noexcept;
+
+		bool open(const Path& path);
+		void close();
+
+		inline bool is_open() const { return _open; }
+		inline bool is_mapped() const { return _mapped; }
+
+		inline const char* data() const { return _data; }
+		inline Size size() const { return _size; }
+
+		inline const char* begin() const { return _data; }
+		inline const char* end() const { return _data + _size; }
+
+		inline operator bool() const { return _open; }
+		inline bool operator! () const { return !_open; }
+	};
+}
+
+
+
 namespace utils::json
 {
-	class JsonException : std::exception
+	class JsonException : public std::runtime_error
 	{
 	public:
-		inline JsonException(const char* msg = "") : std::exception{ msg } {}
-		inline JsonException(const String& msg) : std::exception{ msg.c_str() } {}
+		inline JsonException(const char* msg = "") : std::runtime_error{ msg } {}
+		inline JsonException(const String& msg) : std::runtime_error{ msg } {}
 	};
 
 	class JsonSerializable
@@ -171,6 +224,85 @@ namespace utils::json
 	template<typename _Ty>
 	concept JsonSerializableOnly = utils::BaseOf<JsonSerializable, _Ty>;
 
+	// Receives nlohmann SAX events and keeps track of where they happen, so
+	// derived handlers only override enter/leave/value. key() and index()
+	// always describe the position of the current value inside its parent.
+	// Calling capture() from enter() collects that whole container into a Json
+	// that is delivered through value() once it is closed.
+	class JsonSaxHandler : public nlohmann::json_sax<Json>
+	{
+	private:
+		struct Scope
+		{
+			String key;
+			Size index;
+			bool array;
+		};
+
+	private:
+		std::vector<Scope> _scopes;
+		std::vector<Json*> _captures;
+		Json _captured;
+		bool _capture = false;
+
+	public:
+		bool null() final;
+		bool boolean(bool val) final;
+		bool number_integer(number_integer_t val) final;
+		bool number_unsigned(number_unsigned_t val) final;
+		bool number_float(number_float_t val, const string_t& s) final;
+		bool string(string_t& val) final;
+
+		bool start_object(std::size_t elements) final;
+		bool key(string_t& val) final;
+		bool end_object() final;
+
+		bool start_array(std::size_t elements) final;
+		bool end_array() final;
+
+		bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) final;
+
+	protected:
+		inline Size depth() const { return _scopes.size(); }
+		inline bool in_array() const { return !_scopes.empty() && _scopes.back().array; }
+
+		const String& key() const;
+		inline Size index() const { return _scopes.empty() ? 0 : _scopes.back().index; }
+
+		inline void capture() { _capture = true; }
+
+		virtual bool enter([[maybe_unused]] bool array) { return true; }
+		virtual bool leave([[maybe_unused]] bool array) { return true; }
+		virtual bool value([[maybe_unused]] Json&& value) { return true; }
+
+	private:
+		bool _value(Json&& value);
+		bool _enter(bool array);
+		bool _leave(bool array);
+	};
+
+	template<typename _Ty>
+	concept JsonStreamDeserializable = JsonSerializableOnly<_Ty> && requires(_Ty& obj) {
+		{ obj.stream_deserializer() } -> std::derived_from<JsonSaxHandler>;
+	};
+
+	// Types that declare their fields with a static json_fields() table (see
+	// json_reflect.h) are read and written by generated code instead of going
+	// through virtual serialize()/deserialize() and a Json DOM.
+	template<typename _Ty>
+	concept JsonReflectable = std::is_class_v<_Ty> && requires { _Ty::json_fields(); };
+
+	template<typename _Ty>
+	concept JsonInjectable = JsonSerializableOnly<_Ty> || JsonReflectable<_Ty>;
+
+	template<JsonReflectable _Ty>
+	void read(std::istream& input, _Ty& obj);
+
+	class LazyJson;
+
+	template<JsonReflectable _Ty>
+	void write(std::ostream& output, const _Ty& obj);
+
 	Json read(std::istream& input);
 	Json read(const Path& path);
 	Json read(const String& path);
@@ -187,26 +319,90 @@ namespace utils::json
 	inline void read(const Path& path, JsonSerializable& js) { js.deserialize(read(path)); }
 	inline void read(const String& path, JsonSerializable& js) { js.deserialize(read(path)); }
 
+	void read(std::istream& input, JsonSaxHandler& handler);
+	void read(const Path& path, JsonSaxHandler& handler);
+	void read(const String& path, JsonSaxHandler& handler);
+
+	Json read(const char* begin, const char* end);
+	void read(const char* begin, const char* end, JsonSaxHandler& handler);
+
+	inline Json read(const MappedFile& file) { return read(file.begin(), file.end()); }
+	inline void read(const MappedFile& file, JsonSaxHandler& handler) { read(file.begin(), file.end(), handler); }
+
+	Json read_mapped(const Path& path);
+	void read_mapped(const Path& path, JsonSaxHandler& handler);
+
+	struct ReadResult
+	{
+		Json json;
+		String error;
+
+		inline bool ok() const { return error.empty(); }
+	};
+
+	// Parses every file on a worker pool and returns the results in input
+	// order. threads = 0 uses the shared pool, 1 reads on the calling thread.
+	std::vector<ReadResult> read_many(const std::vector<Path>& paths, Size threads = 0);
+
+	enum class BinaryFormat
+	{
+		Cbor,
+		MessagePack,
+		Ubjson
+	};
+
+	std::vector<UInt8> to_binary(const Json& json, BinaryFormat format);
+	Json from_binary(const char* data, Size size, BinaryFormat format);
+
+	template<JsonStreamDeserializable _Ty>
+	void read(std::istream& input, _Ty& js)
+	{
+		auto handler = js.stream_deserializer();
+		read(input, handler);
+	}
+
+	template<JsonStreamDeserializable _Ty>
+	void read(const Path& path, _Ty& js)
+	{
+		auto handler = js.stream_deserializer();
+		read(path, handler);
+	}
+
+	template<JsonStreamDeserializable _Ty>
+	void read(const String& path, _Ty& js)
+	{
+		auto handler = js.stream_deserializer();
+		read(path, handler);
+	}
+
 	inline void write(std::ostream& output, const JsonSerializable& js) { write(output, js.serialize()); }
 	inline void write(const Path& path, const JsonSerializable& js) { write(path, js.serialize()); }
 	inline void write(const String& path, const JsonSerializable& js) { write(path, js.serialize()); }
 
-	inline bool has(const Json& json, const String& name) { return json.find(name) != json.end(); }
-	inline bool has(const Json& json, const char* name) { return json.find(name) != json.end(); }
-
+	// has/opt accept any nlohmann::basic_json instantiation (Json, FlatJson,
+	// ArenaJson...); names are given in that document's own string type.
 	template<typename _Ty>
-	const _Ty opt(const Json& json, const String& name, const _Ty& default_value)
+	concept JsonValue = nlohmann::detail::is_basic_json<_Ty>::value;
+
+	template<JsonValue _Json>
+	inline bool has(const _Json& json, const typename _Json::string_t& name) { return json.find(name) != json.end(); }
+
+	template<JsonValue _Json>
+	inline bool has(const _Json& json, const char* name) { return json.find(name) != json.end(); }
+
+	template<typename _Ty, JsonValue _Json>
+	const _Ty opt(const _Json& json, const typename _Json::string_t& name, const _Ty& default_value)
 	{
 		auto it = json.find(name);
-		return it == json.end() ? default_value : it.value().get<_Ty>();
+		return it == json.end() ? default_value : it.value().template get<_Ty>();
 	}
 
-	template<typename _Ty>
-	bool opt(const Json& json, const String& name, _Ty& dst)
+	template<typename _Ty, JsonValue _Json>
+	bool opt(const _Json& json, const typename _Json::string_t& name, _Ty& dst)
 	{
 		auto it = json.find(name);
 		if (it != json.end())
-			return dst = it.value().get<_Ty>(), true;
+			return dst = it.value().template get<_Ty>(), true;
 		return false;
 	}
 }
@@ -225,6 +421,70 @@ _Ty& operator>> (_Ty& left, Json& right) { return right = left.serialize(), left
 
 namespace resource
 {
+	// Keeps a binary encoding of every text JSON file read through it in a
+	// cache directory. Entries are keyed by the source path and remember the
+	// size and modification time they were built from, so a changed source
+	// is parsed again and its entry rewritten. Folder::readJson goes through
+	// the active cache, if one has been enabled.
+	class JsonCache
+	{
+	public:
+		using Format = utils::json::BinaryFormat;
+
+	private:
+		Path _directory;
+		Format _format;
+
+	public:
+		JsonCache(const Path& directory, Format format = Format::Cbor);
+		JsonCache(const JsonCache&) = default;
+		JsonCache(JsonCache&&) noexcept = default;
+		~JsonCache() = default;
+
+		JsonCache& operator= (const JsonCache&) = default;
+		JsonCache& operator= (JsonCache&&) noexcept = default;
+
+		bool read(const Path& source, Json& json) const;
+
+		Path entryOf(const Path& source) const;
+
+		void clear() const;
+
+		inline const Path& directory() const { return _directory; }
+		inline Format format() const { return _format; }
+
+	public:
+		static void enable(const Path& directory, Format format = Format::Cbor);
+		static void disable();
+
+		static std::shared_ptr<const JsonCache> active();
+
+	private:
+		Path _entryOf(const String& key) const;
+
+		bool _load(const Path& entry, const String& source, UInt64 size, Int64 mtime, Json& json) const;
+		void _store(const Path& entry, const String& source, UInt64 size, Int64 mtime, const Json& json) const;
+	};
+
+
+
+	// Whole contents of a file, kept alive by owner: either a mapping of a
+	// loose file or a view into a mounted Pack.
+	struct FileView
+	{
+		std::shared_ptr<const void> owner;
+		std::string_view data;
+	};
+
+
+
+	// Reads below the root of a mounted VirtualFolder (see resource_vfs.h)
+	// are resolved through its index alone. Otherwise they go to the
+	// mounted Pack first (see resource_pack.h) when this folder lies under
+	// its root, and to loose files after that. Streams opened into a
+	// caller's std::ifstream never read from a pack, and all output always
+	// goes to loose files under this folder; a new file is added to the
+	// mounted index as it is opened, so it can be read back.
 	class Folder
 	{
 	private:
@@ -258,6 +518,19 @@ namespace resource
 		bool readJson(const String& filename, Json& json) const;
 		bool readJson(const Path& path, Json& json) const;
 
+		// Indexes the file without parsing it; see json_lazy.h. Separate
+		// from readJson because Json converts to anything, which would make
+		// the overloads ambiguous wherever LazyJson is incomplete.
+		bool readLazyJson(const String& filename, utils::json::LazyJson& json) const;
+		bool readLazyJson(const Path& path, utils::json::LazyJson& json) const;
+
+		// Contents of the file without copying them where possible, for
+		// loadFromMemory and the JSON parser.
+		bool openView(const String& filename, FileView& view) const;
+		bool openView(const Path& path, FileView& view) const;
+
+		std::vector<utils::json::ReadResult> readJsonBatch(const std::vector<Path>& paths, Size threads = 0) const;
+
 		bool writeJson(const String& filename, const Json& json) const;
 		bool writeJson(const Path& path, const Json& json) const;
 
@@ -268,40 +541,42 @@ namespace resource
 		inline bool openOutput(const char* filename, const Function<void(std::ostream&)>& action) const { return openOutput(String{ filename }, action); }
 
 		inline bool readJson(const char* filename, Json& json) const { return readJson(String{ filename }, json); }
+		inline bool readLazyJson(const char* filename, utils::json::LazyJson& json) const { return readLazyJson(String{ filename }, json); }
+		inline bool openView(const char* filename, FileView& view) const { return openView(String{ filename }, view); }
 
 		inline bool writeJson(const char* filename, const Json& json) const { return writeJson(String{ filename }, json); }
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline _Ty& readAndInject(const String& filename, _Ty& obj) const
 		{
 			return openInput(filename, [&obj](std::istream& in) { utils::json::read(in, obj); }), obj;
 		}
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline _Ty& readAndInject(const Path& path, _Ty& obj) const
 		{
 			return openInput(path, [&obj](std::istream& in) { utils::json::read(in, obj); }), obj;
 		}
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline _Ty& readAndInject(const char* filename, _Ty& obj) const
 		{
 			return readAndInject(String{ filename }, obj);
 		}
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline void extractAndWrite(const String& filename, _Ty& obj) const
 		{
 			openOutput(filename, [&obj](std::ostream& os) { utils::json::write(os, obj); });
 		}
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline void extractAndWrite(const Path& path, _Ty& obj) const
 		{
 			openOutput(path, [&obj](std::ostream& os) { utils::json::write(os, obj); });
 		}
 
-		template<utils::json::JsonSerializableOnly _Ty>
+		template<utils::json::JsonInjectable _Ty>
 		inline void extractAndWrite(const char* filename, _Ty& obj) const
 		{
 			extractAndWrite(String{ filename }, obj);
@@ -318,6 +593,11 @@ namespace resource
 		inline const Path& path() const { return _path; }
 
 	private:
+		// Where a read of path goes: false if nothing holds the file,
+		// otherwise either view is set (a packed file, file left empty) or
+		// file names the loose file to open.
+		bool _locate(const Path& path, FileView& view, Path& file) const;
+
 		bool _open(const String& filename, std::ifstream& stream) const;
 		bool _open(const Path& path, std::ifstream& stream) const;
 
@@ -335,13 +615,265 @@ namespace resource
 
 namespace utils
 {
+	constexpr Size cache_line_size = 64;
+
+
+	class SlabPool
+	{
+	private:
+		struct FreeBlock { FreeBlock* next; };
+
+	public:
+		static constexpr Size default_chunk_blocks = 64;
+		static constexpr Size max_chunk_blocks = 4096;
+
+	private:
+		Size _block_size;
+		Size _block_align;
+		Size _chunk_blocks;
+		std::vector<Byte*> _chunks;
+		FreeBlock* _free = nullptr;
+		Byte* _cursor = nullptr;
+		Byte* _limit = nullptr;
+		Size _capacity = 0;
+		Size _used = 0;
+
+	public:
+		SlabPool(Size block_size, Size block_align = alignof(std::max_align_t), Size chunk_blocks = default_chunk_blocks);
+		SlabPool(const SlabPool&) = delete;
+		SlabPool(SlabPool&&) = delete;
+		~SlabPool();
+
+		SlabPool& operator= (const SlabPool&) = delete;
+		SlabPool& operator= (SlabPool&&) = delete;
+
+		void* allocate();
+		void deallocate(void* ptr);
+
+		inline bool fits(Size size, Size align) const { return size <= _block_size && align <= _block_align; }
+
+		inline Size block_size() const { return _block_size; }
+		inline Size block_align() const { return _block_align; }
+		inline Size capacity() const { return _capacity; }
+		inline Size used() const { return _used; }
+		inline Size chunk_count() const { return _chunks.size(); }
+
+	private:
+		void _grow();
+	};
+
+	// Allocates single objects from a SlabPool. Default-constructed
+	// allocators of one type share the calling thread's pool, so containers
+	// made on the same thread compare equal and can hand nodes to each other,
+	// and an empty container costs no allocation. SlabPool takes no locks:
+	// a container that keeps changing on another thread while its creator
+	// still allocates should be given a pool of its own.
 	template<typename _Ty>
+	class PoolAllocator
+	{
+	public:
+		using value_type = _Ty;
+		using propagate_on_container_copy_assignment = std::false_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+		using is_always_equal = std::false_type;
+
+		template<typename _Uty>
+		struct rebind { using other = PoolAllocator<_Uty>; };
+
+	private:
+		std::shared_ptr<SlabPool> _pool;
+
+	public:
+		PoolAllocator() : _pool{ shared() } {}
+		PoolAllocator(const PoolAllocator&) = default;
+		~PoolAllocator() = default;
+
+		PoolAllocator& operator= (const PoolAllocator&) = default;
+
+		explicit PoolAllocator(const std::shared_ptr<SlabPool>& pool) :
+			_pool{ pool && pool->fits(sizeof(_Ty), alignof(_Ty)) ? pool : shared() }
+		{}
+
+		template<typename _Uty>
+		PoolAllocator(const PoolAllocator<_Uty>& other) : PoolAllocator{ other._pool } {}
+
+		template<typename _Uty>
+		bool operator== (const PoolAllocator<_Uty>& right) const { return _pool == right._pool; }
+
+		_Ty* allocate(Size count)
+		{
+			if (count == 1 && _pool->fits(sizeof(_Ty), alignof(_Ty)))
+				return static_cast<_Ty*>(_pool->allocate());
+			return std::allocator<_Ty>{}.allocate(count);
+		}
+
+		void deallocate(_Ty* ptr, Size count)
+		{
+			if (count == 1 && _pool->fits(sizeof(_Ty), alignof(_Ty)))
+				_pool->deallocate(ptr);
+			else std::allocator<_Ty>{}.deallocate(ptr, count);
+		}
+
+		inline const std::shared_ptr<SlabPool>& pool() const { return _pool; }
+
+		// The calling thread's pool for _Ty. Allocators holding it keep it
+		// alive after the thread exits.
+		static const std::shared_ptr<SlabPool>& shared()
+		{
+			static thread_local const std::shared_ptr<SlabPool> pool = std::make_shared<SlabPool>(sizeof(_Ty), alignof(_Ty));
+			return pool;
+		}
+
+		template<typename _Uty>
+		friend class PoolAllocator;
+	};
+
+
+
+	// Bump allocator for data that is freed all at once. Chunks are kept
+	// across reset() so a reused arena stops touching the heap.
+	class Arena
+	{
+	private:
+		struct Chunk
+		{
+			Byte* data;
+			Size size;
+		};
+
+	public:
+		static constexpr Size default_chunk_size = 64 * 1024;
+		static constexpr Size max_chunk_size = 16 * 1024 * 1024;
+
+	private:
+		std::vector<Chunk> _chunks;
+		Offset _chunk = 0;
+		Byte* _cursor = nullptr;
+		Byte* _limit = nullptr;
+		Size _next_chunk_size;
+		Size _used = 0;
+
+		inline static thread_local Arena* _current = nullptr;
+
+	public:
+		explicit Arena(Size chunk_size = default_chunk_size);
+		Arena(const Arena&) = delete;
+		Arena(Arena&&) = delete;
+		~Arena();
+
+		Arena& operator= (const Arena&) = delete;
+		Arena& operator= (Arena&&) = delete;
+
+		inline void* allocate(Size size, Size align = alignof(std::max_align_t))
+		{
+			Byte* ptr = reinterpret_cast<Byte*>((reinterpret_cast<std::uintptr_t>(_cursor) + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1));
+			if (!_cursor || ptr + size > _limit)
+				return _grow(size, align);
+
+			_cursor = ptr + size;
+			_used += size;
+			return ptr;
+		}
+
+		template<typename _Ty, typename... _Args>
+		inline _Ty* create(_Args&&... args) { return new (allocate(sizeof(_Ty), alignof(_Ty))) _Ty(std::forward<_Args>(args)...); }
+
+		void reset();
+
+		inline Size used() const { return _used; }
+		Size capacity() const;
+		inline Size chunk_count() const { return _chunks.size(); }
+
+		// Arena that ArenaAllocator draws from on this thread; see ArenaScope.
+		static inline Arena* current() { return _current; }
+
+	private:
+		void* _grow(Size size, Size align);
+
+		friend class ArenaScope;
+	};
+
+	class ArenaScope
+	{
+	private:
+		Arena* _previous;
+
+	public:
+		inline explicit ArenaScope(Arena& arena) : _previous{ std::exchange(Arena::_current, &arena) } {}
+		ArenaScope(const ArenaScope&) = delete;
+		inline ~ArenaScope() { Arena::_current = _previous; }
+
+		ArenaScope& operator= (const ArenaScope&) = delete;
+	};
+
+	// Stateless allocator over Arena::current(), usable where a container
+	// default-constructs its allocator (nlohmann::basic_json does). Outside an
+	// ArenaScope it falls back to the heap; a one word tag in front of every
+	// block tells deallocate() which memory it got, and arena blocks are only
+	// returned by resetting their arena.
+	template<typename _Ty>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = _Ty;
+		using is_always_equal = std::true_type;
+
+		template<typename _Uty>
+		struct rebind { using other = ArenaAllocator<_Uty>; };
+
+	private:
+		static constexpr Size header_size = std::max(alignof(_Ty), sizeof(UInt64));
+		static constexpr Size block_align = std::max(alignof(_Ty), alignof(UInt64));
+
+		static constexpr UInt64 arena_tag = 0;
+		static constexpr UInt64 heap_tag = 1;
+
+	public:
+		ArenaAllocator() = default;
+
+		template<typename _Uty>
+		ArenaAllocator(const ArenaAllocator<_Uty>&) {}
+
+		template<typename _Uty>
+		bool operator== (const ArenaAllocator<_Uty>&) const { return true; }
+
+		_Ty* allocate(Size count)
+		{
+			const Size bytes = header_size + count * sizeof(_Ty);
+
+			Byte* block;
+			UInt64 tag;
+			if (Arena* arena = Arena::current())
+				block = static_cast<Byte*>(arena->allocate(bytes, block_align)), tag = arena_tag;
+			else block = static_cast<Byte*>(::operator new(bytes, std::align_val_t{ block_align })), tag = heap_tag;
+
+			std::memcpy(block + header_size - sizeof(UInt64), &tag, sizeof(UInt64));
+			return reinterpret_cast<_Ty*>(block + header_size);
+		}
+
+		void deallocate(_Ty* ptr, Size)
+		{
+			Byte* block = reinterpret_cast<Byte*>(ptr) - header_size;
+
+			UInt64 tag;
+			std::memcpy(&tag, block + header_size - sizeof(UInt64), sizeof(UInt64));
+			if (tag == heap_tag)
+				::operator delete(block, std::align_val_t{ block_align });
+		}
+	};
+
+
+
+	template<typename _Ty, typename _Alloc = PoolAllocator<_Ty>>
 	class LinkedList
 	{
 	public:
 		class iterator;
 		class const_iterator;
 
+		using allocator_type = _Alloc;
+
 	private:
 		struct Node
 		{
@@ -351,7 +883,7 @@ namespace utils
 
 			template<typename... _Args>
 			Node(_Args&&... args) :
-				data{ std::forward(args)... },
+				data{ std::forward<_Args>(args)... },
 				next{ nullptr },
 				prev{ nullptr }
 			{}
@@ -412,6 +944,9 @@ namespace utils
 			iterator& operator++ () { if (_node) _node = _node->next; return *this; }
 			iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
 
+			iterator& operator-- () { if (_node) _node = _node->prev; return *this; }
+			iterator operator-- (int) { auto it{ *this }; return --(*this), it; }
+
 			iterator operator+ (Offset offset) const
 			{
 				iterator it{ *this };
@@ -467,6 +1002,9 @@ namespace utils
 			const_iterator& operator++ () { if (_node) _node = _node->next; return *this; }
 			const_iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
 
+			const_iterator& operator-- () { if (_node) _node = _node->prev; return *this; }
+			const_iterator operator-- (int) { auto it{ *this }; return --(*this), it; }
+
 			const_reference operator* () const { return _node->data; }
 
 			const_pointer operator-> () const { return &_node->data; }
@@ -475,6 +1013,89 @@ namespace utils
 			friend class iterator;
 		};
 
+		class reverse_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			Node* _node;
+
+		public:
+			reverse_iterator() : _node{ nullptr } {}
+			reverse_iterator(Node* node) : _node{ node } {}
+			reverse_iterator(const reverse_iterator&) = default;
+			reverse_iterator(reverse_iterator&&) noexcept = default;
+			~reverse_iterator() = default;
+
+			reverse_iterator& operator= (const reverse_iterator&) = default;
+			reverse_iterator& operator= (reverse_iterator&&) noexcept = default;
+
+			bool operator== (const reverse_iterator&) const = default;
+
+			operator bool() const { return _node; }
+			bool operator! () const { return !_node; }
+
+			reverse_iterator& operator++ () { if (_node) _node = _node->prev; return *this; }
+			reverse_iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			reference operator* () const { return _node->data; }
+
+			pointer operator-> () const { return &_node->data; }
+
+			inline iterator base() const { return _node; }
+
+			friend class LinkedList;
+		};
+
+		class const_reverse_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			const Node* _node;
+
+		public:
+			const_reverse_iterator() : _node{ nullptr } {}
+			const_reverse_iterator(const Node* node) : _node{ node } {}
+			const_reverse_iterator(const reverse_iterator& it) : _node{ it._node } {}
+			const_reverse_iterator(const const_reverse_iterator&) = default;
+			const_reverse_iterator(const_reverse_iterator&&) noexcept = default;
+			~const_reverse_iterator() = default;
+
+			const_reverse_iterator& operator= (const const_reverse_iterator&) = default;
+			const_reverse_iterator& operator= (const_reverse_iterator&&) noexcept = default;
+
+			bool operator== (const const_reverse_iterator&) const = default;
+
+			operator bool() const { return _node; }
+			bool operator! () const { return !_node; }
+
+			const_reverse_iterator& operator++ () { if (_node) _node = _node->prev; return *this; }
+			const_reverse_iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			const_reference operator* () const { return _node->data; }
+
+			const_pointer operator-> () const { return &_node->data; }
+
+			inline const_iterator base() const { return _node; }
+
+			friend class LinkedList;
+		};
+
 		inline iterator begin() { return iterator(_head); }
 		inline const_iterator begin() const { return const_iterator(_head); }
 		inline const_iterator cbegin() const { return const_iterator(_head); }
@@ -483,12 +1104,46 @@ namespace utils
 		inline const_iterator end() const { return const_iterator(); }
 		inline const_iterator cend() const { return const_iterator(); }
 
+		inline reverse_iterator rbegin() { return reverse_iterator(_tail); }
+		inline const_reverse_iterator rbegin() const { return const_reverse_iterator(_tail); }
+		inline const_reverse_iterator crbegin() const { return const_reverse_iterator(_tail); }
+
+		inline reverse_iterator rend() { return reverse_iterator(); }
+		inline const_reverse_iterator rend() const { return const_reverse_iterator(); }
+		inline const_reverse_iterator crend() const { return const_reverse_iterator(); }
+
 	private:
+		using NodeAllocator = typename std::allocator_traits<_Alloc>::template rebind_alloc<Node>;
+		using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+		struct Chain
+		{
+			Node* head;
+			Node* tail;
+			Size size;
+		};
+
+		NodeAllocator _alloc;
 		Node* _head = nullptr;
 		Node* _tail = nullptr;
 		Size _size = 0;
 
 	private:
+		template<typename... _Args>
+		Node* _new_node(_Args&&... args)
+		{
+			Node* node = NodeAllocatorTraits::allocate(_alloc, 1);
+			try { NodeAllocatorTraits::construct(_alloc, node, std::forward<_Args>(args)...); }
+			catch (...) { NodeAllocatorTraits::deallocate(_alloc, node, 1); throw; }
+			return node;
+		}
+
+		void _delete_node(Node* node)
+		{
+			NodeAllocatorTraits::destroy(_alloc, node);
+			NodeAllocatorTraits::deallocate(_alloc, node, 1);
+		}
+
 		void _destroy()
 		{
 			if (_head)
@@ -496,7 +1151,7 @@ namespace utils
 				for (Node* node = _head, *next; node; node = next)
 				{
 					next = node->next;
-					delete node;
+					_delete_node(node);
 				}
 			}
 
@@ -506,11 +1161,15 @@ namespace utils
 		LinkedList& _copy(const LinkedList& list, bool reset)
 		{
 			if (reset)
+			{
 				_destroy();
+				if constexpr (NodeAllocatorTraits::propagate_on_container_copy_assignment::value)
+					_alloc = list._alloc;
+			}
 
 			for (Node* node = list._head; node; node = node->next)
 			{
-				Node* newnode = new Node{ node.data };
+				Node* newnode = _new_node(node->data);
 				if (!_head)
 					_head = _tail = newnode;
 				else
@@ -526,11 +1185,20 @@ namespace utils
 		LinkedList& _move(LinkedList&& list, bool reset) noexcept
 		{
 			if (reset)
+			{
 				_destroy();
+				if constexpr (NodeAllocatorTraits::propagate_on_container_move_assignment::value)
+					_alloc = list._alloc;
+			}
 
 			_head = list._head;
 			_tail = list._tail;
 			_size = list._size;
+
+			list._head = list._tail = nullptr;
+			list._size = 0;
+
+			return *this;
 		}
 
 		iterator _push_back(Node* node)
@@ -563,10 +1231,12 @@ namespace utils
 
 		iterator _insert(Node* node, Node* prev)
 		{
-			node->prev = node;
+			node->prev = prev;
 			node->next = prev->next;
 
-			prev->next->prev = node;
+			if (prev->next)
+				prev->next->prev = node;
+			else _tail = node;
 			prev->next = node;
 
 			return ++_size, node;
@@ -580,8 +1250,8 @@ namespace utils
 				return _push_back(node);
 
 			Node* prev = _head;
-			while (index > 0)
-				prev = prev->next, --index;
+			while (--index > 0)
+				prev = prev->next;
 
 			return _insert(node, prev);
 		}
@@ -597,17 +1267,120 @@ namespace utils
 
 			if (node == _head)
 				_head = node->next;
-			else if (node == _tail)
+			if (node == _tail)
 				_tail = node->prev;
 
-			delete node;
+			_delete_node(node);
 			return --_size, next;
 		}
 
+		Chain _unlink(Node* first, Node* last)
+		{
+			if (first == last)
+				return { nullptr, nullptr, 0 };
+
+			Node* tail = last ? last->prev : _tail;
+			Size count = 0;
+			if (first == _head && !last)
+				count = _size;
+			else for (Node* node = first; node != last; node = node->next)
+				++count;
+
+			if (first->prev)
+				first->prev->next = last;
+			else _head = last;
+			if (last)
+				last->prev = first->prev;
+			else _tail = first->prev;
+
+			first->prev = tail->next = nullptr;
+			_size -= count;
+
+			return { first, tail, count };
+		}
+
+		Chain _adopt(LinkedList& owner, Chain chain)
+		{
+			if (_alloc == owner._alloc || !chain.head)
+				return chain;
+
+			Chain adopted{ nullptr, nullptr, 0 };
+			for (Node* node = chain.head, *next; node; node = next)
+			{
+				next = node->next;
+
+				Node* newnode = _new_node(std::move(node->data));
+				if (!adopted.head)
+					adopted.head = newnode;
+				else
+				{
+					newnode->prev = adopted.tail;
+					adopted.tail->next = newnode;
+				}
+				adopted.tail = newnode;
+				++adopted.size;
+
+				owner._delete_node(node);
+			}
+
+			return adopted;
+		}
+
+		// Links chain in before next, or at the back if next is null. prev is
+		// read only here, once chain has been unlinked from this list.
+		iterator _link(Chain chain, Node* next)
+		{
+			if (!chain.head)
+				return next;
+
+			Node* const prev = next ? next->prev : _tail;
+			chain.head->prev = prev;
+			chain.tail->next = next;
+
+			if (chain.tail->next)
+				chain.tail->next->prev = chain.tail;
+			else _tail = chain.tail;
+
+			if (prev)
+				prev->next = chain.head;
+			else _head = chain.head;
+
+			return _size += chain.size, chain.head;
+		}
+
+		template<typename _Compare>
+		static Node* _merge_nodes(Node* left, Node* right, _Compare& comp)
+		{
+			Node* head = nullptr;
+			Node** link = &head;
+
+			while (left && right)
+			{
+				if (comp(right->data, left->data))
+					*link = right, right = right->next;
+				else *link = left, left = left->next;
+				link = &(*link)->next;
+			}
+			*link = left ? left : right;
+
+			return head;
+		}
+
+		void _relink(Node* head)
+		{
+			Node* prev = nullptr;
+			for (Node* node = head; node; node = node->next)
+				node->prev = prev, prev = node;
+
+			_head = head;
+			_tail = prev;
+		}
+
 	public:
 		LinkedList() = default;
-		LinkedList(const LinkedList& list) : LinkedList{} { _copy(list, false); }
-		LinkedList(LinkedList&& list) noexcept : LinkedList{} { _move(std::move(list), false); }
+		explicit LinkedList(const _Alloc& alloc) : _alloc{ alloc } {}
+		LinkedList(const LinkedList& list) : _alloc{ NodeAllocatorTraits::select_on_container_copy_construction(list._alloc) } { _copy(list, false); }
+		LinkedList(LinkedList&& list) noexcept : _alloc{ list._alloc } { _move(std::move(list), false); }
 		~LinkedList() { _destroy(); }
 
 		LinkedList& operator= (const LinkedList& right) { return _copy(right, true); }
@@ -616,46 +1389,48 @@ namespace utils
 		inline bool empty() const { return !_head; }
 		inline Size size() const { return _size; }
 
+		inline _Alloc get_allocator() const { return _Alloc{ _alloc }; }
+
 		inline operator bool() const { return _head; }
 		inline bool operator! () const { return !_head; }
 
 		template<typename... _Args>
-		iterator emplace_back(_Args&&... args) { return _push_back(new Node{ std::forward(args) }); }
+		iterator emplace_back(_Args&&... args) { return _push_back(_new_node(std::forward<_Args>(args)...)); }
 
 		template<typename... _Args>
-		iterator emplace_front(_Args&&... args) { return _push_front(new Node{ std::forward(args) }); }
+		iterator emplace_front(_Args&&... args) { return _push_front(_new_node(std::forward<_Args>(args)...)); }
 
 		template<typename... _Args>
-		iterator emplace(Offset index, _Args&&... args) { return _insert(index, new Node{ std::forward(args) }); }
+		iterator emplace(Offset index, _Args&&... args) { return _insert(index, _new_node(std::forward<_Args>(args)...)); }
 
 		template<typename... _Args>
 		iterator emplace(const iterator& it, _Args&&... args)
 		{
 			if (!it)
-				return emplace_back(std::forward(args));
-			return _insert(new Node{ std::forward(args) }, it._node);
+				return emplace_back(std::forward<_Args>(args)...);
+			return _insert(_new_node(std::forward<_Args>(args)...), it._node);
 		}
 
-		iterator push_back(const _Ty& elem) { return _push_back(new Node{ elem }); }
-		iterator push_back(_Ty&& elem) { return _push_back(new Node{ std::move(elem) }); }
+		iterator push_back(const _Ty& elem) { return _push_back(_new_node(elem)); }
+		iterator push_back(_Ty&& elem) { return _push_back(_new_node(std::move(elem))); }
 
-		iterator push_front(const _Ty& elem) { return _push_front(new Node{ elem }); }
-		iterator push_front(_Ty&& elem) { return _push_front(new Node{ std::move(elem) }); }
+		iterator push_front(const _Ty& elem) { return _push_front(_new_node(elem)); }
+		iterator push_front(_Ty&& elem) { return _push_front(_new_node(std::move(elem))); }
 
-		iterator insert(Offset index, const _Ty& elem) { return _insert(index, new Node{ elem }); }
-		iterator insert(Offset index, _Ty&& elem) { return _insert(index, new Node{ std::move(elem) }); }
+		iterator insert(Offset index, const _Ty& elem) { return _insert(index, _new_node(elem)); }
+		iterator insert(Offset index, _Ty&& elem) { return _insert(index, _new_node(std::move(elem))); }
 
 		iterator insert(const iterator& it, const _Ty& elem)
 		{
 			if (!it)
-				return _push_back(new Node{ elem });
-			return _insert(new Node{ elem }, it._node);
+				return _push_back(_new_node(elem));
+			return _insert(_new_node(elem), it._node);
 		}
 		iterator insert(const iterator& it, _Ty&& elem)
 		{
 			if (!it)
-				return _push_back(new Node{ std::move(elem) });
-			return _insert(new Node{ std::move(elem) }, it._node);
+				return _push_back(_new_node(std::move(elem)));
+			return _insert(_new_node(std::move(elem)), it._node);
 		}
 
 		iterator get_iterator(const _Ty* elem_ptr) const
@@ -663,7 +1438,7 @@ namespace utils
 			for (Node* node = _head; node; node = node->next)
 				if (&node->data == elem_ptr)
 					return node;
-			return end();
+			return iterator();
 		}
 
 		iterator get_iterator(const _Ty& elem) const
@@ -671,14 +1446,14 @@ namespace utils
 			for (Node* node = _head; node; node = node->next)
 				if (&node->data == &elem)
 					return node;
-			return end();
+			return iterator();
 		}
 
 		iterator get_iterator(Offset index) const
 		{
 			Node* node = _head;
 			while (node && index > 0)
-				node = node->next;
+				node = node->next, --index;
 			return node;
 		}
 
@@ -705,6 +1480,91 @@ namespace utils
 
 		inline void clear() { _destroy(); }
 
+		// Moves elements of other in front of it, or to the back for end(),
+		// as std::list does (unlike insert(), which places after it). other
+		// may be this list, except for the whole-list overload. Nodes are
+		// relinked, not copied, when both lists share an allocator. Returns
+		// the first element moved, or it if there was none.
+		iterator splice(const iterator& it, LinkedList& other)
+		{
+			if (&other == this)
+				return it;
+			return _link(_adopt(other, other._unlink(other._head, nullptr)), it._node);
+		}
+
+		iterator splice(const iterator& it, LinkedList&& other) { return splice(it, other); }
+
+		iterator splice(const iterator& it, LinkedList& other, const iterator& elem)
+		{
+			if (!elem || elem == it)
+				return it;
+			return _link(_adopt(other, other._unlink(elem._node, elem._node->next)), it._node);
+		}
+
+		iterator splice(const iterator& it, LinkedList& other, const iterator& from, const iterator& to)
+		{
+			if (!from || from == to)
+				return it;
+			return _link(_adopt(other, other._unlink(from._node, to._node)), it._node);
+		}
+
+		template<typename _Compare>
+		void merge(LinkedList& other, _Compare comp)
+		{
+			if (&other == this || !other._head)
+				return;
+
+			const Chain chain = _adopt(other, other._unlink(other._head, nullptr));
+			_relink(_merge_nodes(_head, chain.head, comp));
+			_size += chain.size;
+		}
+
+		inline void merge(LinkedList& other) { merge(other, std::less<>{}); }
+		inline void merge(LinkedList&& other) { merge(other, std::less<>{}); }
+
+		template<typename _Compare>
+		inline void merge(LinkedList&& other, _Compare comp) { merge(other, comp); }
+
+		template<typename _Compare>
+		void sort(_Compare comp)
+		{
+			if (_size < 2)
+				return;
+
+			Node* runs[sizeof(Size) * 8] = {};
+			const Size max_run = sizeof(Size) * 8 - 1;
+
+			for (Node* node = _head, *next; node; node = next)
+			{
+				next = node->next;
+				node->next = nullptr;
+
+				Size run = 0;
+				for (; run < max_run && runs[run]; ++run)
+				{
+					node = _merge_nodes(runs[run], node, comp);
+					runs[run] = nullptr;
+				}
+				runs[run] = runs[run] ? _merge_nodes(runs[run], node, comp) : node;
+			}
+
+			Node* result = nullptr;
+			for (Node* run : runs)
+				if (run)
+					result = result ? _merge_nodes(run, result, comp) : run;
+
+			_relink(result);
+		}
+
+		inline void sort() { sort(std::less<>{}); }
+
+		void reverse()
+		{
+			for (Node* node = _head; node; node = node->prev)
+				std::swap(node->next, node->prev);
+			std::swap(_head, _tail);
+		}
+
 		void clear(const Function<void(_Ty&)>& onDestroyAction)
 		{
 			if (_head)
@@ -713,7 +1573,7 @@ namespace utils
 				{
 					next = node->next;
 					onDestroyAction(node->data);
-					delete node;
+					_delete_node(node);
 				}
 			}
 
@@ -735,36 +1595,35 @@ namespace utils
 
 		LinkedList& operator+= (const LinkedList& right)
 		{
-			for (Node* node = right._head; node; node = node->next)
-				_push_back(new Node{ node->data });
+			Node* node = right._head;
+			for (Size count = right._size; count > 0; --count, node = node->next)
+				_push_back(_new_node(node->data));
 			return *this;
 		}
 
-		LinkedList& operator+= (LinkedList&& right)
-		{
-			_tail->next = right._head;
-			if (right._head)
-			{
-				right._head->prev = _tail;
-				_tail = right._tail;
-			}
-			_size += right._size;
-
-			right._head = right._tail = nullptr;
-			right._size = 0;
+		LinkedList& operator+= (LinkedList&& right) { return splice(end(), right), *this; }
 
-			return *this;
+		LinkedList operator+ (const LinkedList& right) const&
+		{
+			LinkedList list = *this;
+			return list += right;
 		}
 
-		LinkedList operator+ (const LinkedList& right)
+		LinkedList operator+ (LinkedList&& right) const&
 		{
 			LinkedList list = *this;
+			return list += std::move(right);
+		}
+
+		LinkedList operator+ (const LinkedList& right)&&
+		{
+			LinkedList list = std::move(*this);
 			return list += right;
 		}
 
-		LinkedList operator+ (LinkedList&& right)
+		LinkedList operator+ (LinkedList&& right)&&
 		{
-			LinkedList list = *this;
+			LinkedList list = std::move(*this);
 			return list += std::move(right);
 		}
 
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	constexpr Size queue_capacity(Size capacity)
+	{
+		Size result = 2;
+		while (result < capacity)
+			result <<= 1;
+		return result;
+	}
+
+
+
+	template<typename _Ty>
+	class alignas(cache_line_size) SpscQueue
+	{
+	private:
+		struct Slot
+		{
+			alignas(_Ty) Byte storage[sizeof(_Ty)];
+
+			inline _Ty* get() { return std::launder(reinterpret_cast<_Ty*>(storage)); }
+		};
+
+	private:
+		const Size _capacity;
+		const Size _mask;
+		std::unique_ptr<Slot[]> _slots;
+
+		alignas(cache_line_size) std::atomic<Size> _head{ 0 };
+		Size _tail_cache = 0;
+
+		alignas(cache_line_size) std::atomic<Size> _tail{ 0 };
+		Size _head_cache = 0;
+
+	public:
+		explicit SpscQueue(Size capacity) :
+			_capacity{ queue_capacity(capacity) },
+			_mask{ _capacity - 1 },
+			_slots{ std::make_unique<Slot[]>(_capacity) }
+		{}
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue(SpscQueue&&) = delete;
+		~SpscQueue()
+		{
+			for (Size head = _head.load(std::memory_order_relaxed), tail = _tail.load(std::memory_order_relaxed); head != tail; ++head)
+				std::destroy_at(_slots[head & _mask].get());
+		}
+
+		SpscQueue& operator= (const SpscQueue&) = delete;
+		SpscQueue& operator= (SpscQueue&&) = delete;
+
+		inline Size capacity() const { return _capacity; }
+		inline Size size_approx() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+		inline bool empty() const { return size_approx() == 0; }
+
+		template<typename... _Args>
+		bool try_emplace(_Args&&... args)
+		{
+			const Size tail = _tail.load(std::memory_order_relaxed);
+			if (tail - _head_cache >= _capacity)
+			{
+				_head_cache = _head.load(std::memory_order_acquire);
+				if (tail - _head_cache >= _capacity)
+					return false;
+			}
+
+			new (_slots[tail & _mask].storage) _Ty{ std::forward<_Args>(args)... };
+			_tail.store(tail + 1, std::memory_order_release);
+			_tail.notify_one();
+			return true;
+		}
+
+		inline bool try_push(const _Ty& value) { return try_emplace(value); }
+		inline bool try_push(_Ty&& value) { return try_emplace(std::move(value)); }
+
+		template<typename... _Args>
+		void emplace_wait(_Args&&... args)
+		{
+			for (;;)
+			{
+				const Size tail = _tail.load(std::memory_order_relaxed);
+				if (tail - _head.load(std::memory_order_acquire) < _capacity)
+					break;
+				_head.wait(tail - _capacity, std::memory_order_acquire);
+			}
+			try_emplace(std::forward<_Args>(args)...);
+		}
+
+		inline void push_wait(const _Ty& value) { emplace_wait(value); }
+		inline void push_wait(_Ty&& value) { emplace_wait(std::move(value)); }
+
+		template<typename _InputIt>
+		Size push_batch(_InputIt first, Size count)
+		{
+			const Size tail = _tail.load(std::memory_order_relaxed);
+			Size free = _capacity - (tail - _head_cache);
+			if (free < count)
+			{
+				_head_cache = _head.load(std::memory_order_acquire);
+				free = _capacity - (tail - _head_cache);
+			}
+
+			count = std::min(count, free);
+			for (Size i = 0; i < count; ++i, ++first)
+				new (_slots[(tail + i) & _mask].storage) _Ty{ *first };
+
+			if (count > 0)
+			{
+				_tail.store(tail + count, std::memory_order_release);
+				_tail.notify_one();
+			}
+			return count;
+		}
+
+		bool try_pop(_Ty& value)
+		{
+			const Size head = _head.load(std::memory_order_relaxed);
+			if (head == _tail_cache)
+			{
+				_tail_cache = _tail.load(std::memory_order_acquire);
+				if (head == _tail_cache)
+					return false;
+			}
+
+			_Ty* elem = _slots[head & _mask].get();
+			value = std::move(*elem);
+			std::destroy_at(elem);
+
+			_head.store(head + 1, std::memory_order_release);
+			_head.notify_one();
+			return true;
+		}
+
+		void pop_wait(_Ty& value)
+		{
+			while (!try_pop(value))
+				_tail.wait(_head.load(std::memory_order_relaxed), std::memory_order_acquire);
+		}
+
+		template<typename _OutputIt>
+		Size pop_batch(_OutputIt out, Size max_count)
+		{
+			const Size head = _head.load(std::memory_order_relaxed);
+			Size available = _tail_cache - head;
+			if (available < max_count)
+			{
+				_tail_cache = _tail.load(std::memory_order_acquire);
+				available = _tail_cache - head;
+			}
+
+			const Size count = std::min(max_count, available);
+			for (Size i = 0; i < count; ++i, ++out)
+			{
+				_Ty* elem = _slots[(head + i) & _mask].get();
+				*out = std::move(*elem);
+				std::destroy_at(elem);
+			}
+
+			if (count > 0)
+			{
+				_head.store(head + count, std::memory_order_release);
+				_head.notify_one();
+			}
+			return count;
+		}
+	};
+
+
+
+	template<typename _Ty>
+	class alignas(cache_line_size) MpscQueue
+	{
+	private:
+		struct Cell
+		{
+			std::atomic<Size> sequence;
+			alignas(_Ty) Byte storage[sizeof(_Ty)];
+
+			inline _Ty* get() { return std::launder(reinterpret_cast<_Ty*>(storage)); }
+		};
+
+	private:
+		const Size _capacity;
+		const Size _mask;
+		std::unique_ptr<Cell[]> _cells;
+
+		alignas(cache_line_size) std::atomic<Size> _head{ 0 };
+
+		alignas(cache_line_size) std::atomic<Size> _tail{ 0 };
+
+	public:
+		explicit MpscQueue(Size capacity) :
+			_capacity{ queue_capacity(capacity) },
+			_mask{ _capacity - 1 },
+			_cells{ std::make_unique<Cell[]>(_capacity) }
+		{
+			for (Size i = 0; i < _capacity; ++i)
+				_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue(MpscQueue&&) = delete;
+		~MpscQueue()
+		{
+			for (Size head = _head.load(std::memory_order_relaxed); _cells[head & _mask].sequence.load(std::memory_order_relaxed) == head + 1; ++head)
+				std::destroy_at(_cells[head & _mask].get());
+		}
+
+		MpscQueue& operator= (const MpscQueue&) = delete;
+		MpscQueue& operator= (MpscQueue&&) = delete;
+
+		inline Size capacity() const { return _capacity; }
+		inline Size size_approx() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+		inline bool empty() const { return size_approx() == 0; }
+
+	private:
+		inline static std::ptrdiff_t _distance(Size sequence, Size pos) { return static_cast<std::ptrdiff_t>(sequence - pos); }
+
+		bool _claim(Size& pos, Size count)
+		{
+			pos = _tail.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				const Size last = pos + count - 1;
+				const std::ptrdiff_t dif = _distance(_cells[last & _mask].sequence.load(std::memory_order_acquire), last);
+				if (dif == 0)
+				{
+					if (_tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+						return true;
+				}
+				else if (dif < 0)
+					return false;
+				else pos = _tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		inline void _publish(Size pos)
+		{
+			Cell& cell = _cells[pos & _mask];
+			cell.sequence.store(pos + 1, std::memory_order_release);
+			cell.sequence.notify_all();
+		}
+
+	public:
+		template<typename... _Args>
+		bool try_emplace(_Args&&... args)
+		{
+			Size pos;
+			if (!_claim(pos, 1))
+				return false;
+
+			new (_cells[pos & _mask].storage) _Ty{ std::forward<_Args>(args)... };
+			_publish(pos);
+			return true;
+		}
+
+		inline bool try_push(const _Ty& value) { return try_emplace(value); }
+		inline bool try_push(_Ty&& value) { return try_emplace(std::move(value)); }
+
+		template<typename... _Args>
+		void emplace_wait(_Args&&... args)
+		{
+			Size pos;
+			while (!_claim(pos, 1))
+			{
+				Cell& cell = _cells[pos & _mask];
+				const Size sequence = cell.sequence.load(std::memory_order_acquire);
+				if (_distance(sequence, pos) < 0)
+					cell.sequence.wait(sequence, std::memory_order_acquire);
+			}
+
+			new (_cells[pos & _mask].storage) _Ty{ std::forward<_Args>(args)... };
+			_publish(pos);
+		}
+
+		inline void push_wait(const _Ty& value) { emplace_wait(value); }
+		inline void push_wait(_Ty&& value) { emplace_wait(std::move(value)); }
+
+		template<typename _InputIt>
+		Size push_batch(_InputIt first, Size count)
+		{
+			Size pos;
+			for (count = std::min(count, _capacity); count > 0; count /= 2)
+			{
+				if (_claim(pos, count))
+					break;
+			}
+
+			for (Size i = 0; i < count; ++i, ++first)
+				new (_cells[(pos + i) & _mask].storage) _Ty{ *first };
+			for (Size i = 0; i < count; ++i)
+				_publish(pos + i);
+
+			return count;
+		}
+
+		bool try_pop(_Ty& value)
+		{
+			const Size head = _head.load(std::memory_order_relaxed);
+			Cell& cell = _cells[head & _mask];
+			if (cell.sequence.load(std::memory_order_acquire) != head + 1)
+				return false;
+
+			_Ty* elem = cell.get();
+			value = std::move(*elem);
+			std::destroy_at(elem);
+
+			cell.sequence.store(head + _capacity, std::memory_order_release);
+			cell.sequence.notify_all();
+			_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		void pop_wait(_Ty& value)
+		{
+			while (!try_pop(value))
+			{
+				const Size head = _head.load(std::memory_order_relaxed);
+				_cells[head & _mask].sequence.wait(head, std::memory_order_acquire);
+			}
+		}
+
+		template<typename _OutputIt>
+		Size pop_batch(_OutputIt out, Size max_count)
+		{
+			const Size head = _head.load(std::memory_order_relaxed);
+
+			Size count = 0;
+			for (; count < max_count; ++count, ++out)
+			{
+				Cell& cell = _cells[(head + count) & _mask];
+				if (cell.sequence.load(std::memory_order_acquire) != head + count + 1)
+					break;
+
+				_Ty* elem = cell.get();
+				*out = std::move(*elem);
+				std::destroy_at(elem);
+
+				cell.sequence.store(head + count + _capacity, std::memory_order_release);
+				cell.sequence.notify_all();
+			}
+
+			if (count > 0)
+				_head.store(head + count, std::memory_order_release);
+			return count;
+		}
+	};
+}
@@ -0,0 +1,357 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	template<typename _Tag>
+	class IntrusiveListBase;
+
+	template<typename _Tag = void>
+	class IntrusiveListHook
+	{
+	private:
+		IntrusiveListHook* _next = nullptr;
+		IntrusiveListHook* _prev = nullptr;
+		IntrusiveListBase<_Tag>* _owner = nullptr;
+
+	public:
+		IntrusiveListHook() = default;
+		IntrusiveListHook(const IntrusiveListHook&) : IntrusiveListHook{} {}
+		~IntrusiveListHook() { unlink(); }
+
+		IntrusiveListHook& operator= (const IntrusiveListHook&) { return *this; }
+
+		inline bool is_linked() const { return _owner; }
+
+		inline void unlink() { if (_owner) _owner->_unlink(this); }
+
+		friend class IntrusiveListBase<_Tag>;
+	};
+
+	template<typename _Tag>
+	class IntrusiveListBase
+	{
+	protected:
+		using Hook = IntrusiveListHook<_Tag>;
+
+		Hook* _head = nullptr;
+		Hook* _tail = nullptr;
+		Size _size = 0;
+
+	protected:
+		IntrusiveListBase() = default;
+		IntrusiveListBase(const IntrusiveListBase&) = delete;
+		IntrusiveListBase(IntrusiveListBase&& other) noexcept { _steal(other); }
+		~IntrusiveListBase() { _unlink_all(); }
+
+		IntrusiveListBase& operator= (const IntrusiveListBase&) = delete;
+		IntrusiveListBase& operator= (IntrusiveListBase&& right) noexcept
+		{
+			if (this != &right)
+			{
+				_unlink_all();
+				_steal(right);
+			}
+			return *this;
+		}
+
+		static inline Hook* _next_of(const Hook* hook) { return hook->_next; }
+		static inline Hook* _prev_of(const Hook* hook) { return hook->_prev; }
+		inline bool _owns(const Hook* hook) const { return hook->_owner == this; }
+
+		Hook* _link_back(Hook* hook)
+		{
+			hook->unlink();
+			hook->_owner = this;
+
+			if (!_head)
+				_head = _tail = hook;
+			else
+			{
+				hook->_prev = _tail;
+				_tail->_next = hook;
+				_tail = hook;
+			}
+
+			return ++_size, hook;
+		}
+
+		Hook* _link_front(Hook* hook)
+		{
+			hook->unlink();
+			hook->_owner = this;
+
+			if (!_head)
+				_head = _tail = hook;
+			else
+			{
+				hook->_next = _head;
+				_head->_prev = hook;
+				_head = hook;
+			}
+
+			return ++_size, hook;
+		}
+
+		Hook* _link_after(Hook* hook, Hook* prev)
+		{
+			if (hook == prev)
+				return hook;
+
+			hook->unlink();
+			hook->_owner = this;
+			hook->_prev = prev;
+			hook->_next = prev->_next;
+
+			if (prev->_next)
+				prev->_next->_prev = hook;
+			else _tail = hook;
+			prev->_next = hook;
+
+			return ++_size, hook;
+		}
+
+		Hook* _unlink(Hook* hook)
+		{
+			Hook* next = hook->_next;
+
+			if (hook->_next)
+				hook->_next->_prev = hook->_prev;
+			if (hook->_prev)
+				hook->_prev->_next = hook->_next;
+
+			if (hook == _head)
+				_head = hook->_next;
+			if (hook == _tail)
+				_tail = hook->_prev;
+
+			hook->_next = hook->_prev = nullptr;
+			hook->_owner = nullptr;
+
+			return --_size, next;
+		}
+
+		void _unlink_all()
+		{
+			for (Hook* hook = _head, *next; hook; hook = next)
+			{
+				next = hook->_next;
+				hook->_next = hook->_prev = nullptr;
+				hook->_owner = nullptr;
+			}
+
+			_head = _tail = nullptr;
+			_size = 0;
+		}
+
+		void _steal(IntrusiveListBase& other)
+		{
+			_head = other._head;
+			_tail = other._tail;
+			_size = other._size;
+
+			for (Hook* hook = _head; hook; hook = hook->_next)
+				hook->_owner = this;
+
+			other._head = other._tail = nullptr;
+			other._size = 0;
+		}
+
+		friend class IntrusiveListHook<_Tag>;
+	};
+
+
+
+	template<typename _Ty, typename _Tag = void>
+	class IntrusiveList : private IntrusiveListBase<_Tag>
+	{
+	private:
+		using Base = IntrusiveListBase<_Tag>;
+		using Hook = IntrusiveListHook<_Tag>;
+
+		static inline _Ty* _elem(Hook* hook) { return static_cast<_Ty*>(hook); }
+		static inline const _Ty* _elem(const Hook* hook) { return static_cast<const _Ty*>(hook); }
+
+		static inline Hook* _hook(const _Ty* elem)
+		{
+			static_assert(utils::BaseOf<Hook, _Ty>, "IntrusiveList elements must derive from IntrusiveListHook<_Tag>");
+			return static_cast<Hook*>(const_cast<_Ty*>(elem));
+		}
+
+	public:
+		class iterator;
+		class const_iterator;
+
+		class iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			Hook* _node;
+
+		public:
+			iterator() : _node{ nullptr } {}
+			iterator(Hook* node) : _node{ node } {}
+			iterator(const iterator&) = default;
+			iterator(iterator&&) noexcept = default;
+			~iterator() = default;
+
+			iterator& operator= (const iterator&) = default;
+			iterator& operator= (iterator&&) noexcept = default;
+
+			bool operator== (const iterator&) const = default;
+
+			operator bool() const { return _node; }
+			bool operator! () const { return !_node; }
+
+			iterator& operator++ () { if (_node) _node = Base::_next_of(_node); return *this; }
+			iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			iterator operator+ (Offset offset) const
+			{
+				iterator it{ *this };
+				for (; it._node && offset > 0; --offset)
+					it._node = Base::_next_of(it._node);
+				return it;
+			}
+
+			reference operator* () const { return *_elem(_node); }
+
+			pointer operator-> () const { return _elem(_node); }
+
+			friend class IntrusiveList;
+			friend class const_iterator;
+		};
+
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = _Ty;
+			using pointer = _Ty*;
+			using reference = _Ty&;
+			using const_pointer = const _Ty*;
+			using const_reference = const _Ty&;
+
+		private:
+			const Hook* _node;
+
+		public:
+			const_iterator() : _node{ nullptr } {}
+			const_iterator(const Hook* node) : _node{ node } {}
+			const_iterator(const iterator& it) : _node{ it._node } {}
+			const_iterator(const const_iterator&) = default;
+			const_iterator(const_iterator&&) noexcept = default;
+			~const_iterator() = default;
+
+			const_iterator& operator= (const iterator& right) { return _node = right._node, *this; };
+			const_iterator& operator= (const const_iterator&) = default;
+			const_iterator& operator= (const_iterator&&) noexcept = default;
+
+			bool operator== (const const_iterator&) const = default;
+
+			operator bool() const { return _node; }
+			bool operator! () const { return !_node; }
+
+			const_iterator& operator++ () { if (_node) _node = Base::_next_of(_node); return *this; }
+			const_iterator operator++ (int) { auto it{ *this }; return ++(*this), it; }
+
+			const_reference operator* () const { return *_elem(_node); }
+
+			const_pointer operator-> () const { return _elem(_node); }
+
+			friend class IntrusiveList;
+			friend class iterator;
+		};
+
+		inline iterator begin() { return iterator(this->_head); }
+		inline const_iterator begin() const { return const_iterator(this->_head); }
+		inline const_iterator cbegin() const { return const_iterator(this->_head); }
+
+		inline iterator end() { return iterator(); }
+		inline const_iterator end() const { return const_iterator(); }
+		inline const_iterator cend() const { return const_iterator(); }
+
+	public:
+		IntrusiveList() = default;
+		IntrusiveList(const IntrusiveList&) = delete;
+		IntrusiveList(IntrusiveList&&) noexcept = default;
+		~IntrusiveList() = default;
+
+		IntrusiveList& operator= (const IntrusiveList&) = delete;
+		IntrusiveList& operator= (IntrusiveList&&) noexcept = default;
+
+		inline bool empty() const { return !this->_head; }
+		inline Size size() const { return this->_size; }
+
+		inline operator bool() const { return this->_head; }
+		inline bool operator! () const { return !this->_head; }
+
+		inline iterator push_back(_Ty& elem) { return this->_link_back(_hook(&elem)); }
+		inline iterator push_front(_Ty& elem) { return this->_link_front(_hook(&elem)); }
+
+		iterator insert(const iterator& it, _Ty& elem)
+		{
+			if (!it)
+				return push_back(elem);
+			return this->_link_after(_hook(&elem), it._node);
+		}
+
+		inline bool contains(const _Ty* elem_ptr) const { return elem_ptr && this->_owns(_hook(elem_ptr)); }
+		inline bool contains(const _Ty& elem) const { return this->_owns(_hook(&elem)); }
+
+		inline iterator get_iterator(const _Ty* elem_ptr) const { return contains(elem_ptr) ? iterator(_hook(elem_ptr)) : iterator(); }
+		inline iterator get_iterator(const _Ty& elem) const { return contains(elem) ? iterator(_hook(&elem)) : iterator(); }
+
+		iterator erase(const iterator& it)
+		{
+			if (it._node && this->_owns(it._node))
+				return this->_unlink(it._node);
+			return end();
+		}
+
+		iterator erase(const iterator& from, const iterator& to)
+		{
+			iterator it = from;
+			while (it != to)
+				it = erase(it);
+			return it;
+		}
+
+		inline iterator erase(const _Ty* elem_ptr) { return erase(get_iterator(elem_ptr)); }
+
+		inline iterator erase(const _Ty& elem) { return erase(get_iterator(elem)); }
+
+		inline void pop_front() { if (this->_head) this->_unlink(this->_head); }
+		inline void pop_back() { if (this->_tail) this->_unlink(this->_tail); }
+
+		inline void clear() { this->_unlink_all(); }
+
+		void clear(const Function<void(_Ty&)>& onUnlinkAction)
+		{
+			while (this->_head)
+			{
+				Hook* hook = this->_head;
+				this->_unlink(hook);
+				onUnlinkAction(*_elem(hook));
+			}
+		}
+
+		inline _Ty& front() { return *_elem(this->_head); }
+		inline const _Ty& front() const { return *_elem(this->_head); }
+
+		inline _Ty& back() { return *_elem(this->_tail); }
+		inline const _Ty& back() const { return *_elem(this->_tail); }
+
+		inline IntrusiveList& operator<< (_Ty& right) { return push_back(right), *this; }
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils::json
+{
+	using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+	// Json whose strings, arrays and objects live in the current Arena. Meant
+	// for load-and-discard documents: parse with read(..., arena), use the
+	// result, then reset the arena instead of destroying the tree. Keys are
+	// ArenaStrings, so look them up with string literals or ArenaString.
+	using ArenaJson = nlohmann::basic_json<std::map, std::vector, ArenaString, bool, Int64, UInt64, double, ArenaAllocator>;
+
+	// The returned document is placed in the arena and is never destroyed;
+	// it stays valid until the arena is reset. Only change it inside an
+	// ArenaScope of that arena: outside one, new nodes and strings fall back
+	// to the heap, and since the tree is never destroyed those blocks are
+	// never freed.
+	inline ArenaJson& read(const MappedFile& file, Arena& arena)
+	{
+		ArenaScope scope{ arena };
+		try
+		{
+			return *arena.create<ArenaJson>(ArenaJson::parse(file.begin(), file.end()));
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	inline ArenaJson& read(std::istream& input, Arena& arena)
+	{
+		ArenaScope scope{ arena };
+		try
+		{
+			return *arena.create<ArenaJson>(ArenaJson::parse(input));
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	inline ArenaJson& read(const Path& path, Arena& arena)
+	{
+		MappedFile file;
+		if (file.open(path))
+			return read(file, arena);
+
+		std::fstream f{ path, std::ios::in };
+		return read(f, arena);
+	}
+
+	inline ArenaJson& read(const String& path, Arena& arena) { return read(Path{ path }, arena); }
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "common.h"
+
+#include <string_view>
+
+namespace utils
+{
+	template<typename _Ty>
+	concept FlatMapKey = std::convertible_to<const _Ty&, std::string_view>;
+
+	// Associative container over one contiguous vector kept sorted by key.
+	// Shaped after std::map so it can stand in as nlohmann's object_t: small
+	// records are a single allocation and a lookup is a binary search over
+	// adjacent entries instead of a walk over tree nodes. Keys must be
+	// convertible to std::string_view; lookups accept anything that is, so
+	// _Compare must be able to compare keys with those types, as the
+	// default std::less<> (also what nlohmann passes) does.
+	//
+	// Inserting a key places it in order, moving every entry after it: a
+	// map built one key at a time costs O(n^2) moves unless the keys come
+	// in order. That is cheap for the small records this is meant for; for
+	// large ones, the range insert() appends and sorts once.
+	template<typename _Kty, typename _Ty, typename _Compare = std::less<>, typename _Alloc = std::allocator<std::pair<const _Kty, _Ty>>>
+	class FlatMap
+	{
+	public:
+		using key_type = _Kty;
+		using mapped_type = _Ty;
+		using value_type = std::pair<_Kty, _Ty>;
+		using size_type = Size;
+		using difference_type = std::ptrdiff_t;
+		using key_compare = _Compare;
+		using allocator_type = typename std::allocator_traits<_Alloc>::template rebind_alloc<value_type>;
+
+	private:
+		using Storage = std::vector<value_type, allocator_type>;
+
+	public:
+		using iterator = typename Storage::iterator;
+		using const_iterator = typename Storage::const_iterator;
+
+	private:
+		Storage _entries;
+		[[no_unique_address]] _Compare _compare;
+
+	public:
+		FlatMap() = default;
+		FlatMap(const FlatMap&) = default;
+		FlatMap(FlatMap&&) noexcept = default;
+		~FlatMap() = default;
+
+		FlatMap& operator= (const FlatMap&) = default;
+		FlatMap& operator= (FlatMap&&) noexcept = default;
+
+		template<typename _InputIt>
+		FlatMap(_InputIt first, _InputIt last) { insert(first, last); }
+
+		FlatMap(std::initializer_list<value_type> values) { insert(values.begin(), values.end()); }
+
+		inline iterator begin() { return _entries.begin(); }
+		inline const_iterator begin() const { return _entries.begin(); }
+		inline const_iterator cbegin() const { return _entries.cbegin(); }
+
+		inline iterator end() { return _entries.end(); }
+		inline const_iterator end() const { return _entries.end(); }
+		inline const_iterator cend() const { return _entries.cend(); }
+
+		inline bool empty() const { return _entries.empty(); }
+		inline Size size() const { return _entries.size(); }
+		inline Size max_size() const { return _entries.max_size(); }
+		inline Size capacity() const { return _entries.capacity(); }
+
+		inline void reserve(Size count) { _entries.reserve(count); }
+		inline void clear() { _entries.clear(); }
+
+		template<FlatMapKey _Key>
+		iterator find(const _Key& key)
+		{
+			const auto it = _lower_bound(key);
+			return it != _entries.end() && !_compare(key, it->first) ? it : _entries.end();
+		}
+
+		template<FlatMapKey _Key>
+		const_iterator find(const _Key& key) const { return const_cast<FlatMap*>(this)->find(key); }
+
+		template<FlatMapKey _Key>
+		inline Size count(const _Key& key) const { return find(key) != end() ? 1 : 0; }
+
+		template<FlatMapKey _Key>
+		inline bool contains(const _Key& key) const { return find(key) != end(); }
+
+		template<FlatMapKey _Key>
+		_Ty& at(const _Key& key)
+		{
+			const auto it = find(key);
+			if (it == _entries.end())
+				throw std::out_of_range{ "FlatMap key not found" };
+			return it->second;
+		}
+
+		template<FlatMapKey _Key>
+		const _Ty& at(const _Key& key) const { return const_cast<FlatMap*>(this)->at(key); }
+
+		_Ty& operator[] (const _Kty& key) { return try_emplace(key).first->second; }
+		_Ty& operator[] (_Kty&& key) { return try_emplace(std::move(key)).first->second; }
+
+		template<FlatMapKey _Key, typename... _Args>
+		std::pair<iterator, bool> try_emplace(_Key&& key, _Args&&... args)
+		{
+			auto it = _lower_bound(key);
+			if (it != _entries.end() && !_compare(key, it->first))
+				return { it, false };
+
+			it = _entries.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<_Key>(key)), std::forward_as_tuple(std::forward<_Args>(args)...));
+			return { it, true };
+		}
+
+		template<FlatMapKey _Key, typename _Value>
+		inline std::pair<iterator, bool> emplace(_Key&& key, _Value&& value) { return try_emplace(std::forward<_Key>(key), std::forward<_Value>(value)); }
+
+		inline std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+		inline std::pair<iterator, bool> insert(value_type&& value) { return try_emplace(std::move(value.first), std::move(value.second)); }
+
+		// Keys already present, and repeated ones, keep their first value,
+		// as with std::map.
+		template<typename _InputIt>
+		void insert(_InputIt first, _InputIt last)
+		{
+			const Size start = _entries.size();
+			try
+			{
+				for (; first != last; ++first)
+					_entries.emplace_back(first->first, first->second);
+			}
+			catch (...) { _entries.erase(_entries.begin() + start, _entries.end()); throw; }
+
+			const auto less = [this](const value_type& left, const value_type& right) { return _compare(left.first, right.first); };
+			std::stable_sort(_entries.begin(), _entries.end(), less);
+			_entries.erase(std::unique(_entries.begin(), _entries.end(), [&less](const value_type& left, const value_type& right) { return !less(left, right); }), _entries.end());
+		}
+
+		inline iterator erase(iterator pos) { return _entries.erase(pos); }
+		inline iterator erase(const_iterator pos) { return _entries.erase(pos); }
+		inline iterator erase(const_iterator first, const_iterator last) { return _entries.erase(first, last); }
+
+		template<FlatMapKey _Key>
+		Size erase(const _Key& key)
+		{
+			const auto it = find(key);
+			if (it == _entries.end())
+				return 0;
+			return _entries.erase(it), 1;
+		}
+
+		inline bool operator== (const FlatMap& right) const { return _entries == right._entries; }
+		inline bool operator< (const FlatMap& right) const { return _entries < right._entries; }
+
+	private:
+		template<FlatMapKey _Key>
+		inline iterator _lower_bound(const _Key& key)
+		{
+			return std::lower_bound(_entries.begin(), _entries.end(), key, [this](const value_type& entry, const _Key& k) { return _compare(entry.first, k); });
+		}
+	};
+}
+
+namespace utils::json
+{
+	// Json with FlatMap objects. Iteration order and dump() output match
+	// Json, since both keep keys sorted.
+	using FlatJson = nlohmann::basic_json<FlatMap>;
+
+	inline void read(const MappedFile& file, FlatJson& json)
+	{
+		try { json = FlatJson::parse(file.begin(), file.end()); }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	inline void read(std::istream& input, FlatJson& json)
+	{
+		try { json = FlatJson::parse(input); }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	inline void read(const Path& path, FlatJson& json)
+	{
+		MappedFile file;
+		if (file.open(path))
+			return read(file, json);
+
+		std::fstream f{ path, std::ios::in };
+		read(f, json);
+	}
+
+	inline void read(const String& path, FlatJson& json) { read(Path{ path }, json); }
+
+	inline void write(std::ostream& output, const FlatJson& json)
+	{
+		try { output << json; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	inline void write(const Path& path, const FlatJson& json)
+	{
+		std::fstream f{ path, std::ios::out };
+		write(f, json);
+	}
+
+	inline void write(const String& path, const FlatJson& json) { write(Path{ path }, json); }
+}
@@ -0,0 +1,284 @@
+#include "json_intern.h"
+
+#include <cstring>
+
+namespace utils
+{
+	InternedString::InternedString(std::string_view str) :
+		_block{ str.empty() ? nullptr : _allocate(str, str.size(), false) }
+	{}
+
+	InternedString::InternedString(Size count, char c) :
+		_block{ nullptr }
+	{
+		resize(count, c);
+	}
+
+	InternedString::InternedString(const InternedString& other) :
+		_block{ nullptr }
+	{
+		if (!other._block)
+			return;
+
+		if (other._block->pooled)
+		{
+			other._block->refs.fetch_add(1, std::memory_order_relaxed);
+			_block = other._block;
+		}
+		else if (other._block->size > 0)
+			_block = _allocate(other.view(), other.size(), false);
+	}
+
+	InternedString& InternedString::operator= (const InternedString& other)
+	{
+		if (_block != other._block)
+			*this = InternedString{ other };
+		return *this;
+	}
+
+	InternedString& InternedString::operator= (InternedString&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_release();
+			_block = std::exchange(other._block, nullptr);
+		}
+		return *this;
+	}
+
+	void InternedString::clear()
+	{
+		if (_block && !_block->pooled)
+		{
+			_block->size = 0;
+			_block->data()[0] = '\0';
+		}
+		else
+		{
+			_release();
+			_block = nullptr;
+		}
+	}
+
+	void InternedString::reserve(Size capacity)
+	{
+		if (!_block || _block->pooled || _block->capacity < capacity)
+			_detach(capacity);
+	}
+
+	void InternedString::resize(Size size, char c)
+	{
+		if (size > this->size())
+		{
+			reserve(size);
+			std::memset(_block->data() + _block->size, c, size - _block->size);
+		}
+		else if (size < this->size() && _block->pooled)
+			_detach(size);
+
+		if (_block)
+		{
+			_block->size = static_cast<UInt32>(size);
+			_block->data()[size] = '\0';
+		}
+	}
+
+	void InternedString::push_back(char c)
+	{
+		if (!_block || _block->pooled || _block->size == _block->capacity)
+			_detach(std::max<Size>(size() * 2, 15));
+
+		_block->data()[_block->size++] = c;
+		_block->data()[_block->size] = '\0';
+	}
+
+	InternedString& InternedString::append(const char* str, Size size)
+	{
+		const Size needed = this->size() + size;
+		if (!_block || _block->pooled || _block->capacity < needed)
+		{
+			// str may point into this string (s.append(s.view())); _detach
+			// copies those bytes to the same offset before releasing them.
+			const char* data = this->data();
+			const bool aliased = _block && str >= data && str < data + this->size();
+			const Offset offset = aliased ? static_cast<Offset>(str - data) : 0;
+			_detach(std::max(needed, this->size() * 2));
+			if (aliased)
+				str = _block->data() + offset;
+		}
+
+		std::memcpy(_block->data() + _block->size, str, size);
+		_block->size = static_cast<UInt32>(needed);
+		_block->data()[needed] = '\0';
+		return *this;
+	}
+
+	InternedString::Block* InternedString::_allocate(std::string_view str, Size capacity, bool pooled)
+	{
+		if (capacity > std::numeric_limits<UInt32>::max())
+			throw std::length_error{ "InternedString too long" };
+
+		Block* block = new (::operator new(sizeof(Block) + capacity + 1)) Block{ 1, static_cast<UInt32>(str.size()), static_cast<UInt32>(capacity), pooled };
+		std::memcpy(block->data(), str.data(), str.size());
+		block->data()[str.size()] = '\0';
+		return block;
+	}
+
+	void InternedString::_release()
+	{
+		if (!_block)
+			return;
+
+		// Owned blocks are never shared, pooled ones are freed by their last
+		// reference.
+		if (!_block->pooled || _block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			_block->~Block();
+			::operator delete(_block);
+		}
+	}
+
+	void InternedString::_detach(Size capacity)
+	{
+		Block* block = _allocate(view(), std::max(capacity, size()), false);
+		_release();
+		_block = block;
+	}
+
+
+
+	StringPool::StringPool(Size max_value_length) :
+		_entries{},
+		_max_value_length{ max_value_length }
+	{}
+
+	InternedString StringPool::intern(std::string_view str)
+	{
+		const auto it = _entries.find(str);
+		if (it != _entries.end())
+			return it->second;
+
+		InternedString entry;
+		entry._block = InternedString::_allocate(str, str.size(), true);
+		_bytes += sizeof(InternedString::Block) + str.size() + 1;
+		return _entries.emplace(entry.view(), std::move(entry)).first->second;
+	}
+
+	void StringPool::clear()
+	{
+		_entries.clear();
+		_bytes = 0;
+	}
+}
+
+namespace
+{
+	using utils::json::InternedJson;
+
+	// Builds an InternedJson like nlohmann's own DOM parser, but takes keys
+	// and short string values from the pool instead of copying them.
+	class InterningBuilder
+	{
+	private:
+		InternedJson& _root;
+		utils::StringPool& _pool;
+		std::vector<InternedJson*> _stack;
+		InternedJson* _element = nullptr;
+
+	public:
+		InterningBuilder(InternedJson& root, utils::StringPool& pool) : _root{ root }, _pool{ pool } {}
+
+		bool null() { return _add(nullptr), true; }
+		bool boolean(bool val) { return _add(val), true; }
+		bool number_integer(InternedJson::number_integer_t val) { return _add(val), true; }
+		bool number_unsigned(InternedJson::number_unsigned_t val) { return _add(val), true; }
+		bool number_float(InternedJson::number_float_t val, const InternedJson::string_t&) { return _add(val), true; }
+
+		bool string(InternedJson::string_t& val)
+		{
+			if (_pool.interns_value(val.size()))
+				_add(_pool.intern(val));
+			else _add(val);
+			return true;
+		}
+
+		bool start_object(std::size_t)
+		{
+			_stack.push_back(_add(InternedJson::value_t::object));
+			return true;
+		}
+
+		bool key(InternedJson::string_t& val)
+		{
+			_element = &(*_stack.back())[_pool.intern(val)];
+			return true;
+		}
+
+		bool end_object() { return _stack.pop_back(), true; }
+
+		bool start_array(std::size_t)
+		{
+			_stack.push_back(_add(InternedJson::value_t::array));
+			return true;
+		}
+
+		bool end_array() { return _stack.pop_back(), true; }
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+		{
+			throw utils::json::JsonException{ ex.what() };
+		}
+
+	private:
+		template<typename _Ty>
+		InternedJson* _add(_Ty&& value)
+		{
+			if (_stack.empty())
+			{
+				_root = InternedJson(std::forward<_Ty>(value));
+				return &_root;
+			}
+
+			if (_stack.back()->is_array())
+				return &_stack.back()->emplace_back(std::forward<_Ty>(value));
+
+			*_element = InternedJson(std::forward<_Ty>(value));
+			return _element;
+		}
+	};
+}
+
+namespace utils::json
+{
+	void read(const MappedFile& file, InternedJson& json, StringPool& pool)
+	{
+		InterningBuilder builder{ json, pool };
+		try
+		{
+			InternedJson::sax_parse(file.begin(), file.end(), &builder);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	void read(std::istream& input, InternedJson& json, StringPool& pool)
+	{
+		InterningBuilder builder{ json, pool };
+		try
+		{
+			InternedJson::sax_parse(input, &builder);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	void read(const Path& path, InternedJson& json, StringPool& pool)
+	{
+		MappedFile file;
+		if (file.open(path))
+			return read(file, json, pool);
+
+		std::fstream f{ path, std::ios::in };
+		read(f, json, pool);
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "common.h"
+
+#include <string_view>
+
+namespace utils
+{
+	// Pointer-sized string for nlohmann::basic_json. It either owns its bytes
+	// or refers to a shared, immutable entry of a StringPool; copying a pooled
+	// string only bumps a reference count, and writing to one detaches it
+	// first. Pooled entries are reference counted, so documents may outlive
+	// the pool that produced them.
+	class InternedString
+	{
+	public:
+		using value_type = char;
+		using traits_type = std::char_traits<char>;
+		using size_type = Size;
+		using difference_type = std::ptrdiff_t;
+		using reference = const char&;
+		using const_reference = const char&;
+		using pointer = const char*;
+		using const_pointer = const char*;
+		using iterator = const char*;
+		using const_iterator = const char*;
+
+		static constexpr Size npos = static_cast<Size>(-1);
+
+	private:
+		struct Block
+		{
+			std::atomic<UInt32> refs;
+			UInt32 size;
+			UInt32 capacity;
+			bool pooled;
+
+			inline char* data() { return reinterpret_cast<char*>(this + 1); }
+		};
+
+	private:
+		Block* _block = nullptr;
+
+	public:
+		InternedString() = default;
+		InternedString(std::string_view str);
+		inline InternedString(const char* str) : InternedString{ std::string_view{ str } } {}
+		inline InternedString(const char* str, Size size) : InternedString{ std::string_view{ str, size } } {}
+		inline InternedString(const String& str) : InternedString{ std::string_view{ str } } {}
+		InternedString(Size count, char c);
+		InternedString(const InternedString& other);
+		inline InternedString(InternedString&& other) noexcept : _block{ std::exchange(other._block, nullptr) } {}
+		inline ~InternedString() { _release(); }
+
+		InternedString& operator= (const InternedString& other);
+		InternedString& operator= (InternedString&& other) noexcept;
+		inline InternedString& operator= (std::string_view str) { return *this = InternedString{ str }; }
+		inline InternedString& operator= (const char* str) { return *this = InternedString{ str }; }
+		inline InternedString& operator= (const String& str) { return *this = InternedString{ str }; }
+
+		inline const char* data() const { return _block ? _block->data() : ""; }
+		inline const char* c_str() const { return data(); }
+		inline Size size() const { return _block ? _block->size : 0; }
+		inline Size length() const { return size(); }
+		inline bool empty() const { return size() == 0; }
+		inline bool pooled() const { return _block && _block->pooled; }
+
+		inline const char* begin() const { return data(); }
+		inline const char* end() const { return data() + size(); }
+		inline const char* cbegin() const { return begin(); }
+		inline const char* cend() const { return end(); }
+
+		inline const char& operator[] (Offset index) const { return data()[index]; }
+		inline const char& front() const { return data()[0]; }
+		inline const char& back() const { return data()[size() - 1]; }
+
+		inline std::string_view view() const { return { data(), size() }; }
+		inline operator std::string_view() const { return view(); }
+		inline String str() const { return String{ view() }; }
+
+		void clear();
+		void reserve(Size capacity);
+		void resize(Size size, char c = '\0');
+		void push_back(char c);
+		InternedString& append(const char* str, Size size);
+		inline InternedString& append(std::string_view str) { return append(str.data(), str.size()); }
+		inline InternedString& operator+= (std::string_view str) { return append(str); }
+		inline InternedString& operator+= (char c) { return push_back(c), *this; }
+
+		inline bool operator== (const InternedString& right) const { return _block == right._block || view() == right.view(); }
+		inline bool operator== (std::string_view right) const { return view() == right; }
+		inline bool operator== (const char* right) const { return view() == right; }
+		inline bool operator== (const String& right) const { return view() == right; }
+
+		inline std::strong_ordering operator<=> (const InternedString& right) const { return view() <=> right.view(); }
+		inline std::strong_ordering operator<=> (std::string_view right) const { return view() <=> right; }
+		inline std::strong_ordering operator<=> (const char* right) const { return view() <=> std::string_view{ right }; }
+		inline std::strong_ordering operator<=> (const String& right) const { return view() <=> std::string_view{ right }; }
+
+	private:
+		static Block* _allocate(std::string_view str, Size capacity, bool pooled);
+		void _release();
+		void _detach(Size capacity);
+
+		friend class StringPool;
+	};
+
+	inline std::ostream& operator<< (std::ostream& os, const InternedString& str) { return os << str.view(); }
+
+	// Table of shared strings for InternedString. Interning the same text
+	// twice returns strings that share one entry. Not thread-safe: use one
+	// pool per loading thread.
+	class StringPool
+	{
+	private:
+		std::unordered_map<std::string_view, InternedString> _entries;
+		Size _bytes = 0;
+		Size _max_value_length;
+
+	public:
+		// Keys are always interned. String values are interned when they are
+		// at most max_value_length bytes long; 0 interns keys only.
+		explicit StringPool(Size max_value_length = 0);
+		StringPool(const StringPool&) = delete;
+		StringPool(StringPool&&) = delete;
+		~StringPool() = default;
+
+		StringPool& operator= (const StringPool&) = delete;
+		StringPool& operator= (StringPool&&) = delete;
+
+		InternedString intern(std::string_view str);
+
+		inline bool interns_value(Size length) const { return length <= _max_value_length; }
+		inline Size max_value_length() const { return _max_value_length; }
+
+		inline Size size() const { return _entries.size(); }
+
+		// Bytes held by the entries themselves, excluding the lookup table.
+		inline Size bytes() const { return _bytes; }
+
+		// Drops the pool's own references. Strings still used by documents
+		// stay alive until those documents release them.
+		void clear();
+	};
+}
+
+namespace utils::json
+{
+	// Json whose keys, and optionally short string values, are shared
+	// through a StringPool. Repetitive documents (replays, telemetry, level
+	// data) store each distinct key once instead of once per object.
+	using InternedJson = nlohmann::basic_json<std::map, std::vector, InternedString>;
+
+	void read(const MappedFile& file, InternedJson& json, StringPool& pool);
+	void read(std::istream& input, InternedJson& json, StringPool& pool);
+	void read(const Path& path, InternedJson& json, StringPool& pool);
+	inline void read(const String& path, InternedJson& json, StringPool& pool) { read(Path{ path }, json, pool); }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "common.h"
+
+#include <string_view>
+#include <array>
+
+namespace utils::json
+{
+	// 64-bit FNV-1a, usable at compile time.
+	constexpr UInt64 key_hash(std::string_view name)
+	{
+		UInt64 hash = 0xcbf29ce484222325ull;
+		for (const char c : name)
+			hash = (hash ^ static_cast<UInt8>(c)) * 0x100000001b3ull;
+		return hash;
+	}
+
+	// Object member name with its hash computed once, normally at compile
+	// time: constexpr Key id{ "id" }; or "id"_key.
+	struct Key
+	{
+		std::string_view name;
+		UInt64 hash;
+
+		constexpr Key(std::string_view name) : name{ name }, hash{ key_hash(name) } {}
+		constexpr Key(const char* name) : Key{ std::string_view{ name } } {}
+
+		constexpr bool matches(std::string_view other, UInt64 other_hash) const { return hash == other_hash && name == other; }
+	};
+
+	namespace literals
+	{
+		consteval Key operator""_key(const char* name, Size size) { return Key{ std::string_view{ name, size } }; }
+	}
+
+	// Member lookup without building a temporary key string where the
+	// object type allows it (FlatJson). std::map objects still need a
+	// string_t, which stays within the small-string buffer for short names.
+	template<JsonValue _Json>
+	const _Json* find(const _Json& json, const Key& key)
+	{
+		using Object = typename _Json::object_t;
+
+		const Object* object = json.template get_ptr<const Object*>();
+		if (!object)
+			return nullptr;
+
+		if constexpr (requires { object->find(key.name); })
+		{
+			const auto it = object->find(key.name);
+			return it != object->end() ? &it->second : nullptr;
+		}
+		else
+		{
+			const auto it = object->find(typename _Json::string_t{ key.name });
+			return it != object->end() ? &it->second : nullptr;
+		}
+	}
+
+	template<JsonValue _Json>
+	inline bool has(const _Json& json, const Key& key) { return find(json, key) != nullptr; }
+
+	template<typename _Ty, JsonValue _Json>
+	const _Ty opt(const _Json& json, const Key& key, const _Ty& default_value)
+	{
+		const _Json* value = find(json, key);
+		return value ? value->template get<_Ty>() : default_value;
+	}
+
+	template<typename _Ty, JsonValue _Json>
+	bool opt(const _Json& json, const Key& key, _Ty& dst)
+	{
+		if (const _Json* value = find(json, key))
+			return value->get_to(dst), true;
+		return false;
+	}
+
+	// Fixed set of keys resolved against an object in a single pass over its
+	// members, for deserialization loops that read the same fields from many
+	// objects:
+	//
+	//   static constexpr KeySet keys{ "id", "x", "y" };
+	//   keys.read(record, id, x, y);
+	//
+	// Each member name is hashed once and compared against the precomputed
+	// hashes; the pass stops as soon as every key has been found.
+	template<Size _Count>
+	class KeySet
+	{
+	private:
+		std::array<Key, _Count> _keys;
+
+	public:
+		template<typename... _Names>
+		constexpr KeySet(const _Names&... names) : _keys{ Key{ names }... } {}
+
+		constexpr Size size() const { return _Count; }
+		constexpr const Key& operator[] (Offset index) const { return _keys[index]; }
+
+		// Values in key order; nullptr where the member is missing or json is
+		// not an object.
+		template<JsonValue _Json>
+		std::array<const _Json*, _Count> resolve(const _Json& json) const
+		{
+			std::array<const _Json*, _Count> found{};
+			if (!json.is_object())
+				return found;
+
+			Size remaining = _Count;
+			for (auto it = json.begin(); it != json.end() && remaining > 0; ++it)
+			{
+				const std::string_view name = it.key();
+				const UInt64 hash = key_hash(name);
+				for (Offset i = 0; i < _Count; ++i)
+				{
+					if (!found[i] && _keys[i].matches(name, hash))
+					{
+						found[i] = &it.value();
+						--remaining;
+						break;
+					}
+				}
+			}
+			return found;
+		}
+
+		// Resolves the keys and converts each value found into the matching
+		// argument; missing members leave their argument untouched. Returns
+		// the number of members found.
+		template<JsonValue _Json, typename... _Ty> requires (sizeof...(_Ty) == _Count)
+		Size read(const _Json& json, _Ty&... dst) const
+		{
+			const auto found = resolve(json);
+			Size count = 0;
+			Offset index = 0;
+			((found[index] ? (found[index]->get_to(dst), ++count) : count, ++index), ...);
+			return count;
+		}
+	};
+
+	template<typename... _Names>
+	KeySet(const _Names&...) -> KeySet<sizeof...(_Names)>;
+}
@@ -0,0 +1,229 @@
+#include "json_lazy.h"
+
+#include <cstring>
+
+namespace
+{
+	[[noreturn]] void malformed(const char* at, const char* begin)
+	{
+		throw utils::json::JsonException{ "malformed JSON at offset " + std::to_string(at - begin) };
+	}
+
+	const char* skip_whitespace(const char* ptr, const char* end)
+	{
+		while (ptr < end && (*ptr == ' ' || *ptr == '\n' || *ptr == '\r' || *ptr == '\t'))
+			++ptr;
+		return ptr;
+	}
+
+	// ptr is on the opening quote; returns one past the closing quote.
+	const char* skip_string(const char* ptr, const char* end, const char* begin)
+	{
+		for (++ptr; ptr < end; ++ptr)
+		{
+			const char* quote = static_cast<const char*>(std::memchr(ptr, '"', static_cast<Size>(end - ptr)));
+			if (!quote)
+				break;
+
+			// The quote is escaped when preceded by an odd number of backslashes.
+			const char* slash = quote;
+			while (slash > ptr && slash[-1] == '\\')
+				--slash;
+			if ((quote - slash) % 2 == 0)
+				return quote + 1;
+			ptr = quote;
+		}
+		malformed(end, begin);
+	}
+
+	String decode_key(const char* begin, const char* end)
+	{
+		if (!std::memchr(begin, '\\', static_cast<Size>(end - begin)))
+			return { begin + 1, end - 1 };
+
+		try { return Json::parse(begin, end).get<String>(); }
+		catch (const std::exception& ex) { throw utils::json::JsonException{ ex.what() }; }
+	}
+
+	// Finds the end of the value starting at ptr by matching brackets only;
+	// the contents are checked when the value is parsed.
+	const char* skip_value(const char* ptr, const char* end, const char* begin)
+	{
+		if (ptr >= end)
+			malformed(ptr, begin);
+
+		if (*ptr == '"')
+			return skip_string(ptr, end, begin);
+
+		if (*ptr != '{' && *ptr != '[')
+		{
+			const char* start = ptr;
+			while (ptr < end && *ptr != ',' && *ptr != '}' && *ptr != ']' && *ptr != ' ' && *ptr != '\n' && *ptr != '\r' && *ptr != '\t')
+				++ptr;
+			if (ptr == start)
+				malformed(ptr, begin);
+			return ptr;
+		}
+
+		Size depth = 0;
+		while (ptr < end)
+		{
+			switch (*ptr)
+			{
+				case '"':
+					ptr = skip_string(ptr, end, begin);
+					continue;
+
+				case '{':
+				case '[':
+					++depth;
+					break;
+
+				case '}':
+				case ']':
+					if (--depth == 0)
+						return ptr + 1;
+					break;
+			}
+			++ptr;
+		}
+		malformed(ptr, begin);
+	}
+}
+
+namespace utils::json
+{
+	LazyJson::LazyJson(std::shared_ptr<const MappedFile> file) :
+		LazyJson{ file, file->begin(), file->end() }
+	{}
+
+	LazyJson::LazyJson(String text) :
+		LazyJson{}
+	{
+		const auto owner = std::make_shared<const String>(std::move(text));
+		*this = LazyJson{ owner, owner->data(), owner->data() + owner->size() };
+	}
+
+	LazyJson::LazyJson(std::shared_ptr<const void> owner, const char* begin, const char* end) :
+		_owner{ std::move(owner) },
+		_members{},
+		_elements{}
+	{
+		begin = skip_whitespace(begin, end);
+		while (end > begin && (end[-1] == ' ' || end[-1] == '\n' || end[-1] == '\r' || end[-1] == '\t'))
+			--end;
+		_span = { begin, end };
+		_index();
+	}
+
+	LazyJson LazyJson::at(std::string_view key) const
+	{
+		const Span* span = _find(key);
+		if (!span)
+			throw JsonException{ "key not found: " + String{ key } };
+		return { _owner, span->begin, span->end };
+	}
+
+	LazyJson LazyJson::at(Offset index) const
+	{
+		if (index >= _elements.size())
+			throw JsonException{ "index out of range: " + std::to_string(index) };
+		return { _owner, _elements[index].begin, _elements[index].end };
+	}
+
+	Json LazyJson::get(std::string_view key) const
+	{
+		const Span* span = _find(key);
+		if (!span)
+			throw JsonException{ "key not found: " + String{ key } };
+
+		try { return Json::parse(span->begin, span->end); }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	Json LazyJson::get() const
+	{
+		try { return Json::parse(_span.begin, _span.end); }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	const LazyJson::Span* LazyJson::_find(std::string_view key) const
+	{
+		const auto it = _members.find(key);
+		return it != _members.end() ? &it->second : nullptr;
+	}
+
+	void LazyJson::_index()
+	{
+		if (!is_object() && !is_array())
+			return;
+
+		const char* const base = _span.begin;
+		const char* const end = _span.end;
+		const char close = is_object() ? '}' : ']';
+
+		const char* ptr = skip_whitespace(base + 1, end);
+		if (ptr < end && *ptr == close)
+			++ptr;
+		else for (;;)
+		{
+			if (is_object())
+			{
+				if (ptr >= end || *ptr != '"')
+					malformed(ptr, base);
+
+				const char* key_end = skip_string(ptr, end, base);
+				String key = decode_key(ptr, key_end);
+
+				ptr = skip_whitespace(key_end, end);
+				if (ptr >= end || *ptr != ':')
+					malformed(ptr, base);
+
+				const char* value = skip_whitespace(ptr + 1, end);
+				ptr = skip_value(value, end, base);
+
+				// Later duplicates win, as with Json.
+				_members[std::move(key)] = { value, ptr };
+			}
+			else
+			{
+				const char* value = ptr;
+				ptr = skip_value(value, end, base);
+				_elements.push_back({ value, ptr });
+			}
+
+			ptr = skip_whitespace(ptr, end);
+			if (ptr < end && *ptr == ',')
+				ptr = skip_whitespace(ptr + 1, end);
+			else if (ptr < end && *ptr == close)
+			{
+				++ptr;
+				break;
+			}
+			else malformed(ptr, base);
+		}
+
+		if (ptr != end)
+			malformed(ptr, base);
+	}
+
+	LazyJson read_lazy(const Path& path)
+	{
+		const auto file = std::make_shared<MappedFile>();
+		if (!file->open(path))
+			throw JsonException{ "cannot open " + path.string() };
+		return LazyJson{ std::shared_ptr<const MappedFile>{ file } };
+	}
+}
+
+namespace resource
+{
+	bool Folder::readLazyJson(const String& filename, utils::json::LazyJson& json) const { return readLazyJson(Path{ filename }, json); }
+	bool Folder::readLazyJson(const Path& path, utils::json::LazyJson& json) const
+	{
+		FileView view;
+		if (!openView(path, view))
+			return false;
+		return json = utils::json::LazyJson{ std::move(view.owner), view.data.data(), view.data.data() + view.data.size() }, true;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "json_flat.h"
+
+#include <string_view>
+
+namespace utils::json
+{
+	// Read-only view over JSON text that is parsed on demand. Building one
+	// scans just the outermost value and records where each direct member
+	// (or array element) starts and ends; at() returns another LazyJson over
+	// that span, indexed the same way, and get() parses a span into a Json.
+	// Nothing inside a span is validated until it is parsed. The text is kept
+	// alive by the LazyJson and every view taken from it.
+	class LazyJson
+	{
+	private:
+		struct Span
+		{
+			const char* begin;
+			const char* end;
+		};
+
+	private:
+		std::shared_ptr<const void> _owner;
+		Span _span{ nullptr, nullptr };
+		FlatMap<String, Span> _members;
+		std::vector<Span> _elements;
+
+	public:
+		LazyJson() = default;
+		LazyJson(const LazyJson&) = default;
+		LazyJson(LazyJson&&) noexcept = default;
+		~LazyJson() = default;
+
+		explicit LazyJson(std::shared_ptr<const MappedFile> file);
+		explicit LazyJson(String text);
+		LazyJson(std::shared_ptr<const void> owner, const char* begin, const char* end);
+
+		LazyJson& operator= (const LazyJson&) = default;
+		LazyJson& operator= (LazyJson&&) noexcept = default;
+
+		inline bool empty() const { return _span.begin == _span.end; }
+		inline bool is_object() const { return _first() == '{'; }
+		inline bool is_array() const { return _first() == '['; }
+		inline bool is_string() const { return _first() == '"'; }
+		inline bool is_boolean() const { return _first() == 't' || _first() == 'f'; }
+		inline bool is_null() const { return _first() == 'n'; }
+		inline bool is_number() const { return _first() == '-' || (_first() >= '0' && _first() <= '9'); }
+
+		// Members of an object or elements of an array; 0 for scalars.
+		inline Size size() const { return is_object() ? _members.size() : _elements.size(); }
+
+		inline bool contains(std::string_view key) const { return _members.contains(key); }
+
+		LazyJson at(std::string_view key) const;
+		LazyJson at(Offset index) const;
+
+		// Parses only the given member.
+		Json get(std::string_view key) const;
+
+		Json get() const;
+
+		template<typename _Ty>
+		inline _Ty get() const { return get().get<_Ty>(); }
+
+		inline std::string_view raw() const { return { _span.begin, static_cast<Size>(_span.end - _span.begin) }; }
+
+	private:
+		inline char _first() const { return empty() ? '\0' : *_span.begin; }
+
+		const Span* _find(std::string_view key) const;
+		void _index();
+	};
+
+	inline bool has(const LazyJson& json, std::string_view name) { return json.contains(name); }
+
+	template<typename _Ty>
+	const _Ty opt(const LazyJson& json, std::string_view name, const _Ty& default_value)
+	{
+		return json.contains(name) ? json.get(name).get<_Ty>() : default_value;
+	}
+
+	template<typename _Ty>
+	bool opt(const LazyJson& json, std::string_view name, _Ty& dst)
+	{
+		if (json.contains(name))
+			return dst = json.get(name).get<_Ty>(), true;
+		return false;
+	}
+
+	LazyJson read_lazy(const Path& path);
+	inline LazyJson read_lazy(const String& path) { return read_lazy(Path{ path }); }
+	inline LazyJson read_lazy(const char* path) { return read_lazy(Path{ path }); }
+}
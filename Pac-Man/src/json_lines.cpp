@@ -0,0 +1,101 @@
+#include "json_lines.h"
+
+namespace utils::json
+{
+	JsonLinesWriter::JsonLinesWriter(const Path& path, bool append, Size buffer_size, std::chrono::milliseconds flush_interval) :
+		_output{ path, std::ios::out | std::ios::binary | (append ? std::ios::app : std::ios::trunc) },
+		_buffer{},
+		_serializer{ nlohmann::detail::output_adapter<char>(_buffer), ' ' },
+		_buffer_size{ std::max<Size>(buffer_size, 1) },
+		_flush_interval{ flush_interval },
+		_last_flush{ std::chrono::steady_clock::now() }
+	{
+		_buffer.reserve(_buffer_size + _buffer_size / 4);
+	}
+
+	JsonLinesWriter::~JsonLinesWriter()
+	{
+		flush();
+	}
+
+	void JsonLinesWriter::write(const Json& record)
+	{
+		// A record that fails halfway (invalid UTF-8) is dropped whole, or the
+		// next one would be glued onto its remains.
+		const Size start = _buffer.size();
+		try
+		{
+			_serializer.dump(record, false, false, 0);
+		}
+		catch (const std::exception& ex)
+		{
+			_buffer.resize(start);
+			throw JsonException{ ex.what() };
+		}
+		_end_record();
+	}
+
+	void JsonLinesWriter::flush()
+	{
+		if (!_buffer.empty())
+		{
+			_output.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+			_bytes += _buffer.size();
+			_buffer.clear();
+		}
+		_output.flush();
+		_last_flush = std::chrono::steady_clock::now();
+	}
+
+	void JsonLinesWriter::_end_record()
+	{
+		_buffer += '\n';
+		++_records;
+
+		if (_buffer.size() >= _buffer_size || std::chrono::steady_clock::now() - _last_flush >= _flush_interval)
+			flush();
+	}
+
+
+
+	JsonLinesReader::JsonLinesReader(const Path& path, Size buffer_size) :
+		_stream_buffer(std::max<Size>(buffer_size, 4096)),
+		_input{},
+		_line{}
+	{
+		// The buffer has to be installed before the file is opened.
+		_input.rdbuf()->pubsetbuf(_stream_buffer.data(), static_cast<std::streamsize>(_stream_buffer.size()));
+		_input.open(path, std::ios::in | std::ios::binary);
+	}
+
+	bool JsonLinesReader::next(Json& record)
+	{
+		if (!_next_line())
+			return false;
+
+		try
+		{
+			record = Json::parse(_line);
+		}
+		catch (const std::exception& ex) { _fail(ex); }
+		return true;
+	}
+
+	bool JsonLinesReader::_next_line()
+	{
+		while (std::getline(_input, _line))
+		{
+			++_line_number;
+			if (!_line.empty() && _line.back() == '\r')
+				_line.pop_back();
+			if (_line.find_first_not_of(" \t") != String::npos)
+				return true;
+		}
+		return false;
+	}
+
+	void JsonLinesReader::_fail(const std::exception& ex) const
+	{
+		throw JsonException{ "line " + std::to_string(_line_number) + ": " + ex.what() };
+	}
+}
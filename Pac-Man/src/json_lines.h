@@ -0,0 +1,152 @@
+#pragma once
+
+#include "json_reflect.h"
+
+namespace utils::json
+{
+	// Appends one JSON record per line (JSON Lines) without ever holding more
+	// than a buffer's worth of output. Records are serialized into a reused
+	// string; the string is written to the file once it reaches buffer_size
+	// bytes or flush_interval has passed since the last write, and on
+	// flush() and destruction.
+	class JsonLinesWriter
+	{
+	public:
+		static constexpr Size default_buffer_size = 256 * 1024;
+		static constexpr std::chrono::milliseconds default_flush_interval{ 1000 };
+
+	private:
+		std::ofstream _output;
+		String _buffer;
+		nlohmann::detail::serializer<Json> _serializer;
+		Size _buffer_size;
+		std::chrono::milliseconds _flush_interval;
+		std::chrono::steady_clock::time_point _last_flush;
+		Size _records = 0;
+		Size _bytes = 0;
+
+	public:
+		explicit JsonLinesWriter(const Path& path, bool append = true, Size buffer_size = default_buffer_size, std::chrono::milliseconds flush_interval = default_flush_interval);
+		JsonLinesWriter(const JsonLinesWriter&) = delete;
+		JsonLinesWriter(JsonLinesWriter&&) = delete;
+		~JsonLinesWriter();
+
+		JsonLinesWriter& operator= (const JsonLinesWriter&) = delete;
+		JsonLinesWriter& operator= (JsonLinesWriter&&) = delete;
+
+		inline bool is_open() const { return _output.is_open(); }
+
+		void write(const Json& record);
+		inline void write(const JsonSerializable& record) { write(record.serialize()); }
+
+		template<JsonReflectable _Ty>
+		void write(const _Ty& record)
+		{
+			const Size start = _buffer.size();
+			try { reflect::append_value(_buffer, record); }
+			catch (...) { _buffer.resize(start); throw; }
+			_end_record();
+		}
+
+		void flush();
+
+		// Records and bytes written so far, including buffered ones.
+		inline Size records() const { return _records; }
+		inline Size bytes() const { return _bytes + _buffer.size(); }
+
+	private:
+		void _end_record();
+	};
+
+	// Reads a JSON Lines file one record at a time through a fixed-size
+	// stream buffer, so memory use does not depend on the file size. Blank
+	// lines are skipped; a line that does not parse throws a JsonException
+	// naming its line number.
+	class JsonLinesReader
+	{
+	public:
+		class iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = Json;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Json*;
+			using reference = const Json&;
+
+		private:
+			JsonLinesReader* _reader = nullptr;
+			Json _record;
+
+		public:
+			iterator() = default;
+			inline explicit iterator(JsonLinesReader& reader) : _reader{ &reader } { ++*this; }
+
+			inline const Json& operator* () const { return _record; }
+			inline const Json* operator-> () const { return &_record; }
+
+			inline iterator& operator++ ()
+			{
+				if (!_reader->next(_record))
+					_reader = nullptr;
+				return *this;
+			}
+
+			inline void operator++ (int) { ++*this; }
+
+			inline bool operator== (const iterator& right) const { return _reader == right._reader; }
+		};
+
+	public:
+		static constexpr Size default_buffer_size = 256 * 1024;
+
+	private:
+		std::vector<char> _stream_buffer;
+		std::ifstream _input;
+		String _line;
+		Size _line_number = 0;
+
+	public:
+		explicit JsonLinesReader(const Path& path, Size buffer_size = default_buffer_size);
+		JsonLinesReader(const JsonLinesReader&) = delete;
+		JsonLinesReader(JsonLinesReader&&) = delete;
+		~JsonLinesReader() = default;
+
+		JsonLinesReader& operator= (const JsonLinesReader&) = delete;
+		JsonLinesReader& operator= (JsonLinesReader&&) = delete;
+
+		inline bool is_open() const { return _input.is_open(); }
+
+		// Line number of the record returned last, starting at 1.
+		inline Size line_number() const { return _line_number; }
+
+		bool next(Json& record);
+		inline bool next(JsonSerializable& record)
+		{
+			Json json;
+			return next(json) ? (record.deserialize(json), true) : false;
+		}
+
+		template<JsonReflectable _Ty>
+		bool next(_Ty& record)
+		{
+			if (!_next_line())
+				return false;
+
+			reflect::Reader reader{ reflect::target_of(record) };
+			try
+			{
+				Json::sax_parse(_line.begin(), _line.end(), &reader);
+			}
+			catch (const std::exception& ex) { _fail(ex); }
+			return true;
+		}
+
+		inline iterator begin() { return iterator{ *this }; }
+		inline iterator end() { return {}; }
+
+	private:
+		bool _next_line();
+		[[noreturn]] void _fail(const std::exception& ex) const;
+	};
+}
@@ -0,0 +1,211 @@
+#include "json_reflect.h"
+
+#include <cstring>
+
+namespace utils::json::reflect
+{
+	void append_string(String& out, std::string_view str)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+
+		out += '"';
+		for (const char c : str)
+		{
+			switch (c)
+			{
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\b': out += "\\b"; break;
+				case '\f': out += "\\f"; break;
+				case '\n': out += "\\n"; break;
+				case '\r': out += "\\r"; break;
+				case '\t': out += "\\t"; break;
+				default:
+					if (static_cast<UInt8>(c) < 0x20)
+					{
+						out += "\\u00";
+						out += hex[static_cast<UInt8>(c) >> 4];
+						out += hex[static_cast<UInt8>(c) & 0xf];
+					}
+					else out += c;
+			}
+		}
+		out += '"';
+	}
+
+	void append_number(String& out, double value)
+	{
+		if (!std::isfinite(value))
+		{
+			out += "null";
+			return;
+		}
+
+		char buffer[32];
+		char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+		out.append(buffer, end);
+
+		// Keep floats recognisable as floats when the text is read back.
+		if (std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) == end)
+			out += ".0";
+	}
+
+
+	void append_cbor_head(std::vector<UInt8>& out, UInt8 major, UInt64 value)
+	{
+		const UInt8 type = static_cast<UInt8>(major << 5);
+		if (value < 24)
+			return out.push_back(static_cast<UInt8>(type | value));
+
+		Size bytes;
+		if (value <= 0xff)
+			out.push_back(type | 24), bytes = 1;
+		else if (value <= 0xffff)
+			out.push_back(type | 25), bytes = 2;
+		else if (value <= 0xffffffff)
+			out.push_back(type | 26), bytes = 4;
+		else out.push_back(type | 27), bytes = 8;
+
+		for (Size i = bytes; i > 0; --i)
+			out.push_back(static_cast<UInt8>(value >> ((i - 1) * 8)));
+	}
+
+	void append_cbor_number(std::vector<UInt8>& out, double value)
+	{
+		UInt64 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		out.push_back(0xfb);
+		for (Size i = 8; i > 0; --i)
+			out.push_back(static_cast<UInt8>(bits >> ((i - 1) * 8)));
+	}
+
+
+	Json Scalar::to_json() const
+	{
+		switch (kind)
+		{
+			case Kind::Boolean: return boolean;
+			case Kind::Integer: return integer;
+			case Kind::Unsigned: return unsigned_integer;
+			case Kind::Float: return floating;
+			case Kind::String: return std::move(*string);
+			default: return nullptr;
+		}
+	}
+
+	void type_error(const char* expected)
+	{
+		throw JsonException{ String{ "reflected json: expected " } + expected };
+	}
+
+	namespace
+	{
+		void skip_scalar(void*, const Scalar&) {}
+		void skip_enter(void*, bool) {}
+		Target skip_child(void*, const String&) { return skip_target(); }
+
+		constexpr TargetOps skip_table = { &skip_scalar, &skip_enter, &skip_child, nullptr };
+	}
+
+	Target skip_target() { return { nullptr, &skip_table }; }
+
+
+	Reader::Reader(Target root) :
+		_frames{},
+		_root{ root },
+		_key{},
+		_captures{},
+		_captured{},
+		_capture_target{}
+	{}
+
+	bool Reader::null() { return _scalar({ Scalar::Kind::Null }); }
+	bool Reader::boolean(bool val) { return _scalar({ .kind = Scalar::Kind::Boolean, .boolean = val }); }
+	bool Reader::number_integer(Json::number_integer_t val) { return _scalar({ .kind = Scalar::Kind::Integer, .integer = val }); }
+	bool Reader::number_unsigned(Json::number_unsigned_t val) { return _scalar({ .kind = Scalar::Kind::Unsigned, .unsigned_integer = val }); }
+	bool Reader::number_float(Json::number_float_t val, const Json::string_t&) { return _scalar({ .kind = Scalar::Kind::Float, .floating = val }); }
+	bool Reader::string(Json::string_t& val) { return _scalar({ .kind = Scalar::Kind::String, .string = &val }); }
+
+	bool Reader::start_object(std::size_t) { return _enter(false); }
+	bool Reader::key(Json::string_t& val) { return _key = std::move(val), true; }
+	bool Reader::end_object() { return _leave(); }
+
+	bool Reader::start_array(std::size_t) { return _enter(true); }
+	bool Reader::end_array() { return _leave(); }
+
+	bool Reader::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+	{
+		throw JsonException{ ex.what() };
+	}
+
+	Target Reader::_next()
+	{
+		if (_frames.empty())
+			return _root;
+
+		const Target& parent = _frames.back();
+		return parent.ops->child(parent.object, _key);
+	}
+
+	bool Reader::_scalar(Scalar&& value)
+	{
+		if (!_captures.empty())
+		{
+			Json& parent = *_captures.back();
+			if (parent.is_array())
+				parent.push_back(value.to_json());
+			else parent[_key] = value.to_json();
+			return true;
+		}
+
+		const Target target = _next();
+		if (target.ops->assign)
+			target.ops->assign(target.object, value.to_json());
+		else target.ops->scalar(target.object, value);
+		return true;
+	}
+
+	bool Reader::_enter(bool array)
+	{
+		Json container = array ? Json::array() : Json::object();
+		if (!_captures.empty())
+		{
+			Json& parent = *_captures.back();
+			if (parent.is_array())
+			{
+				parent.push_back(std::move(container));
+				_captures.push_back(&parent.back());
+			}
+			else _captures.push_back(&(parent[_key] = std::move(container)));
+			return true;
+		}
+
+		const Target target = _next();
+		if (target.ops->assign)
+		{
+			_captured = std::move(container);
+			_capture_target = target;
+			_captures.push_back(&_captured);
+			return true;
+		}
+
+		target.ops->enter(target.object, array);
+		_frames.push_back(target);
+		return true;
+	}
+
+	bool Reader::_leave()
+	{
+		if (!_captures.empty())
+		{
+			_captures.pop_back();
+			if (_captures.empty())
+				_capture_target.ops->assign(_capture_target.object, std::move(_captured));
+			return true;
+		}
+
+		_frames.pop_back();
+		return true;
+	}
+}
@@ -0,0 +1,499 @@
+#pragma once
+
+#include "common.h"
+
+#include <string_view>
+#include <charconv>
+#include <tuple>
+
+// Compile-time reflected serialization. A type lists its fields once:
+//
+//	struct Spawn
+//	{
+//		String type;
+//		Int32 x, y;
+//
+//		static constexpr auto json_fields()
+//		{
+//			using utils::json::field;
+//			return utils::json::fields(field("type", &Spawn::type), field("x", &Spawn::x), field("y", &Spawn::y));
+//		}
+//	};
+//
+// and gets DOM conversion (Json j = spawn; j.get<Spawn>()), a text writer, a
+// CBOR writer and a SAX reader that fills the object straight from the parser,
+// for JSON text as well as the binary formats. Fields may be bools, numbers,
+// strings, reflectable types or sequences of those; any other type goes
+// through its own to_json/from_json.
+
+namespace utils::json
+{
+	template<typename _Class, typename _Ty>
+	struct Field
+	{
+		using class_type = _Class;
+		using value_type = _Ty;
+
+		std::string_view name;
+		_Ty _Class::* member;
+	};
+
+	template<typename _Class, typename _Ty>
+	constexpr Field<_Class, _Ty> field(std::string_view name, _Ty _Class::* member) { return { name, member }; }
+
+	template<typename... _Fields>
+	constexpr std::tuple<_Fields...> fields(_Fields... fields) { return { fields... }; }
+
+	template<JsonReflectable _Ty, typename _Fty>
+	constexpr void for_each_field(_Fty&& action)
+	{
+		std::apply([&action](const auto&... fields) { (action(fields), ...); }, _Ty::json_fields());
+	}
+
+	template<typename _Ty>
+	concept JsonSequence = !std::same_as<_Ty, String> && !std::same_as<_Ty, std::vector<bool>> && requires(_Ty& c) {
+		typename _Ty::value_type;
+		c.begin();
+		c.end();
+		c.clear();
+		c.emplace_back();
+		c.back();
+	};
+
+	// Keeps virtual-only call sites working: a reflected type deriving from
+	// JsonReflected<Self> is also a JsonSerializable.
+	template<typename _Derived>
+	class JsonReflected : public JsonSerializable
+	{
+	public:
+		Json serialize() const override;
+		void deserialize(const Json& json) override;
+	};
+}
+
+
+
+namespace utils::json::reflect
+{
+	template<typename _Ty>
+	constexpr bool direct = std::same_as<_Ty, bool> || std::is_arithmetic_v<_Ty> || std::same_as<_Ty, String> || JsonReflectable<_Ty> || JsonSequence<_Ty>;
+
+
+	// DOM
+
+	template<typename _Ty>
+	void to_dom(Json& json, const _Ty& value)
+	{
+		if constexpr (JsonReflectable<_Ty>)
+		{
+			json = Json::object();
+			for_each_field<_Ty>([&](const auto& field) { to_dom(json[String{ field.name }], value.*field.member); });
+		}
+		else if constexpr (JsonSequence<_Ty>)
+		{
+			json = Json::array();
+			for (const auto& elem : value)
+				to_dom(json.emplace_back(), elem);
+		}
+		else json = value;
+	}
+
+	template<typename _Ty>
+	void from_dom(const Json& json, _Ty& value)
+	{
+		if constexpr (JsonReflectable<_Ty>)
+		{
+			for_each_field<_Ty>([&](const auto& field) {
+				auto it = json.find(field.name);
+				if (it != json.end())
+					from_dom(*it, value.*field.member);
+			});
+		}
+		else if constexpr (JsonSequence<_Ty>)
+		{
+			value.clear();
+			for (const Json& elem : json)
+			{
+				value.emplace_back();
+				from_dom(elem, value.back());
+			}
+		}
+		else json.get_to(value);
+	}
+
+
+	// Text
+
+	void append_string(String& out, std::string_view str);
+	void append_number(String& out, double value);
+
+	template<typename _Ty>
+	void append_value(String& out, const _Ty& value)
+	{
+		if constexpr (std::same_as<_Ty, bool>)
+			out += value ? "true" : "false";
+		else if constexpr (std::is_integral_v<_Ty>)
+		{
+			char buffer[24];
+			out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+		}
+		else if constexpr (std::is_floating_point_v<_Ty>)
+			append_number(out, static_cast<double>(value));
+		else if constexpr (std::same_as<_Ty, String>)
+			append_string(out, value);
+		else if constexpr (JsonReflectable<_Ty>)
+		{
+			bool first = true;
+			out += '{';
+			for_each_field<_Ty>([&](const auto& field) {
+				if (!first)
+					out += ',';
+				first = false;
+				append_string(out, field.name);
+				out += ':';
+				append_value(out, value.*field.member);
+			});
+			out += '}';
+		}
+		else if constexpr (JsonSequence<_Ty>)
+		{
+			bool first = true;
+			out += '[';
+			for (const auto& elem : value)
+			{
+				if (!first)
+					out += ',';
+				first = false;
+				append_value(out, elem);
+			}
+			out += ']';
+		}
+		else out += Json(value).dump();
+	}
+
+
+	// CBOR
+
+	void append_cbor_head(std::vector<UInt8>& out, UInt8 major, UInt64 value);
+	void append_cbor_number(std::vector<UInt8>& out, double value);
+
+	template<typename _Ty>
+	void append_cbor(std::vector<UInt8>& out, const _Ty& value)
+	{
+		if constexpr (std::same_as<_Ty, bool>)
+			out.push_back(value ? 0xf5 : 0xf4);
+		else if constexpr (std::is_integral_v<_Ty>)
+		{
+			if constexpr (std::is_signed_v<_Ty>)
+			{
+				if (value < 0)
+					return append_cbor_head(out, 1, static_cast<UInt64>(-(static_cast<Int64>(value) + 1)));
+			}
+			append_cbor_head(out, 0, static_cast<UInt64>(value));
+		}
+		else if constexpr (std::is_floating_point_v<_Ty>)
+			append_cbor_number(out, static_cast<double>(value));
+		else if constexpr (std::same_as<_Ty, String>)
+		{
+			append_cbor_head(out, 3, value.size());
+			out.insert(out.end(), reinterpret_cast<const UInt8*>(value.data()), reinterpret_cast<const UInt8*>(value.data()) + value.size());
+		}
+		else if constexpr (JsonReflectable<_Ty>)
+		{
+			append_cbor_head(out, 5, std::tuple_size_v<decltype(_Ty::json_fields())>);
+			for_each_field<_Ty>([&](const auto& field) {
+				append_cbor_head(out, 3, field.name.size());
+				out.insert(out.end(), reinterpret_cast<const UInt8*>(field.name.data()), reinterpret_cast<const UInt8*>(field.name.data()) + field.name.size());
+				append_cbor(out, value.*field.member);
+			});
+		}
+		else if constexpr (JsonSequence<_Ty>)
+		{
+			append_cbor_head(out, 4, static_cast<UInt64>(std::distance(value.begin(), value.end())));
+			for (const auto& elem : value)
+				append_cbor(out, elem);
+		}
+		else
+		{
+			const std::vector<UInt8> encoded = Json::to_cbor(Json(value));
+			out.insert(out.end(), encoded.begin(), encoded.end());
+		}
+	}
+
+
+	// SAX
+
+	struct Scalar
+	{
+		enum class Kind { Null, Boolean, Integer, Unsigned, Float, String } kind;
+		bool boolean = false;
+		Int64 integer = 0;
+		UInt64 unsigned_integer = 0;
+		double floating = 0;
+		String* string = nullptr;
+
+		Json to_json() const;
+	};
+
+	struct Target;
+
+	// Per-type table of plain functions; the reader keeps one Target per open
+	// container and never needs the value types to share a base class.
+	struct TargetOps
+	{
+		void (*scalar)(void* target, const Scalar& value);
+		void (*enter)(void* target, bool array);
+		Target (*child)(void* target, const String& key);
+		void (*assign)(void* target, Json&& json);
+	};
+
+	struct Target
+	{
+		void* object;
+		const TargetOps* ops;
+	};
+
+	[[noreturn]] void type_error(const char* expected);
+
+	template<typename _Ty>
+	struct Ops
+	{
+		static void scalar(void* target, const Scalar& value)
+		{
+			_Ty& obj = *static_cast<_Ty*>(target);
+			if constexpr (std::same_as<_Ty, bool>)
+			{
+				if (value.kind != Scalar::Kind::Boolean)
+					type_error("boolean");
+				obj = value.boolean;
+			}
+			else if constexpr (std::is_arithmetic_v<_Ty>)
+			{
+				switch (value.kind)
+				{
+					case Scalar::Kind::Integer: obj = static_cast<_Ty>(value.integer); break;
+					case Scalar::Kind::Unsigned: obj = static_cast<_Ty>(value.unsigned_integer); break;
+					case Scalar::Kind::Float: obj = static_cast<_Ty>(value.floating); break;
+					default: type_error("number");
+				}
+			}
+			else if constexpr (std::same_as<_Ty, String>)
+			{
+				if (value.kind != Scalar::Kind::String)
+					type_error("string");
+				obj = std::move(*value.string);
+			}
+			else if constexpr (JsonReflectable<_Ty>)
+			{
+				if (value.kind != Scalar::Kind::Null)
+					type_error("object");
+			}
+			else if constexpr (JsonSequence<_Ty>)
+			{
+				if (value.kind != Scalar::Kind::Null)
+					type_error("array");
+				obj.clear();
+			}
+		}
+
+		static void enter(void* target, bool array)
+		{
+			if constexpr (JsonReflectable<_Ty>)
+			{
+				if (array)
+					type_error("object");
+			}
+			else if constexpr (JsonSequence<_Ty>)
+			{
+				if (!array)
+					type_error("array");
+				static_cast<_Ty*>(target)->clear();
+			}
+			else type_error(std::same_as<_Ty, String> ? "string" : std::same_as<_Ty, bool> ? "boolean" : "number");
+		}
+
+		static Target child(void* target, const String& key);
+
+		static void assign(void* target, Json&& json) { json.get_to(*static_cast<_Ty*>(target)); }
+
+		static constexpr TargetOps table = { &scalar, &enter, &child, direct<_Ty> ? nullptr : &assign };
+	};
+
+	template<typename _Ty>
+	inline Target target_of(_Ty& obj) { return { &obj, &Ops<_Ty>::table }; }
+
+	Target skip_target();
+
+	template<typename _Ty>
+	Target Ops<_Ty>::child(void* target, const String& key)
+	{
+		_Ty& obj = *static_cast<_Ty*>(target);
+		if constexpr (JsonReflectable<_Ty>)
+		{
+			Target result = skip_target();
+			for_each_field<_Ty>([&](const auto& field) {
+				if (field.name == key)
+					result = target_of(obj.*field.member);
+			});
+			return result;
+		}
+		else if constexpr (JsonSequence<_Ty>)
+		{
+			obj.emplace_back();
+			return target_of(obj.back());
+		}
+		else return skip_target();
+	}
+
+	// Satisfies nlohmann's SAX interface without deriving from json_sax, so
+	// sax_parse calls it statically.
+	class Reader
+	{
+	private:
+		std::vector<Target> _frames;
+		Target _root;
+		String _key;
+
+		std::vector<Json*> _captures;
+		Json _captured;
+		Target _capture_target;
+
+	public:
+		explicit Reader(Target root);
+
+		bool null();
+		bool boolean(bool val);
+		bool number_integer(Json::number_integer_t val);
+		bool number_unsigned(Json::number_unsigned_t val);
+		bool number_float(Json::number_float_t val, const Json::string_t& s);
+		bool string(Json::string_t& val);
+
+		bool start_object(std::size_t elements);
+		bool key(Json::string_t& val);
+		bool end_object();
+
+		bool start_array(std::size_t elements);
+		bool end_array();
+
+		bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex);
+
+	private:
+		Target _next();
+		bool _scalar(Scalar&& value);
+		bool _enter(bool array);
+		bool _leave();
+	};
+}
+
+
+
+namespace utils::json
+{
+	template<JsonReflectable _Ty>
+	void read(std::istream& input, _Ty& obj)
+	{
+		reflect::Reader reader{ reflect::target_of(obj) };
+		try
+		{
+			Json::sax_parse(input, &reader);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	template<JsonReflectable _Ty>
+	void read(const MappedFile& file, _Ty& obj)
+	{
+		reflect::Reader reader{ reflect::target_of(obj) };
+		try
+		{
+			Json::sax_parse(file.begin(), file.end(), &reader);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	template<JsonReflectable _Ty>
+	void read(const Path& path, _Ty& obj)
+	{
+		MappedFile file;
+		if (!file.open(path))
+			throw JsonException{ "cannot open " + path.string() };
+		read(file, obj);
+	}
+
+	template<JsonReflectable _Ty>
+	void read(const String& path, _Ty& obj) { read(Path{ path }, obj); }
+
+	template<JsonReflectable _Ty>
+	void read_cbor(const char* data, Size size, _Ty& obj)
+	{
+		reflect::Reader reader{ reflect::target_of(obj) };
+		try
+		{
+			Json::sax_parse(nlohmann::detail::input_adapter(data, size), &reader, nlohmann::detail::input_format_t::cbor);
+		}
+		catch (const JsonException&) { throw; }
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
+	template<JsonReflectable _Ty>
+	String write_string(const _Ty& obj)
+	{
+		String out;
+		reflect::append_value(out, obj);
+		return out;
+	}
+
+	template<JsonReflectable _Ty>
+	void write(std::ostream& output, const _Ty& obj)
+	{
+		const String out = write_string(obj);
+		output.write(out.data(), static_cast<std::streamsize>(out.size()));
+	}
+
+	template<JsonReflectable _Ty>
+	void write(const Path& path, const _Ty& obj)
+	{
+		std::fstream f{ path, std::ios::out };
+		write(f, obj);
+	}
+
+	template<JsonReflectable _Ty>
+	void write(const String& path, const _Ty& obj) { write(Path{ path }, obj); }
+
+	template<JsonReflectable _Ty>
+	std::vector<UInt8> write_cbor(const _Ty& obj)
+	{
+		std::vector<UInt8> out;
+		reflect::append_cbor(out, obj);
+		return out;
+	}
+
+
+	template<typename _Derived>
+	Json JsonReflected<_Derived>::serialize() const
+	{
+		Json json;
+		reflect::to_dom(json, static_cast<const _Derived&>(*this));
+		return json;
+	}
+
+	template<typename _Derived>
+	void JsonReflected<_Derived>::deserialize(const Json& json)
+	{
+		reflect::from_dom(json, static_cast<_Derived&>(*this));
+	}
+}
+
+
+
+namespace nlohmann
+{
+	template<utils::json::JsonReflectable _Ty>
+	struct adl_serializer<_Ty, void>
+	{
+		static void to_json(Json& json, const _Ty& value) { utils::json::reflect::to_dom(json, value); }
+		static void from_json(const Json& json, _Ty& value) { utils::json::reflect::from_dom(json, value); }
+	};
+}
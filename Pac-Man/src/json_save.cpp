@@ -0,0 +1,433 @@
+#include "json_save.h"
+#include "resource_vfs.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <process.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+	int open_file(const Path& path, bool append)
+	{
+		return _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC), _S_IREAD | _S_IWRITE);
+	}
+
+	bool write_all(int fd, const char* data, Size size)
+	{
+		while (size > 0)
+		{
+			const int written = _write(fd, data, static_cast<unsigned int>(std::min<Size>(size, 1 << 30)));
+			if (written <= 0)
+				return false;
+			data += written;
+			size -= static_cast<Size>(written);
+		}
+		return true;
+	}
+
+	inline bool sync_file(int fd) { return _commit(fd) == 0; }
+	inline void close_file(int fd) { _close(fd); }
+	inline int process_id() { return _getpid(); }
+
+	// NTFS makes the rename itself durable; there is no directory handle to sync.
+	inline void sync_directory(const Path&) {}
+
+	// The only mode bit NTFS keeps is read-only, and a read-only target
+	// cannot be replaced anyway.
+	inline void copy_mode(const Path&, int) {}
+#else
+	int open_file(const Path& path, bool append)
+	{
+		return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+	}
+
+	bool write_all(int fd, const char* data, Size size)
+	{
+		while (size > 0)
+		{
+			const ssize_t written = ::write(fd, data, size);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return false;
+			data += written;
+			size -= static_cast<Size>(written);
+		}
+		return true;
+	}
+
+	inline bool sync_file(int fd) { return ::fsync(fd) == 0; }
+	inline void close_file(int fd) { ::close(fd); }
+	inline int process_id() { return static_cast<int>(::getpid()); }
+
+	// Gives fd the permissions of the file at path, if there is one, so that
+	// replacing a file keeps its mode.
+	void copy_mode(const Path& path, int fd)
+	{
+		struct stat status;
+		if (::stat(path.c_str(), &status) == 0)
+			::fchmod(fd, status.st_mode & 07777);
+	}
+
+	// Makes the rename durable, not only the file contents.
+	void sync_directory(const Path& directory)
+	{
+		const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+			::fsync(fd);
+			::close(fd);
+		}
+	}
+#endif
+
+	UInt64 content_hash(std::string_view data)
+	{
+		UInt64 hash = 0xcbf29ce484222325ull;
+		for (const char c : data)
+			hash = (hash ^ static_cast<UInt8>(c)) * 0x100000001b3ull;
+		return hash;
+	}
+}
+
+namespace utils
+{
+	AtomicFile::AtomicFile(const Path& path, Size buffer_size) :
+		_path{ path },
+		_temp{ temp_path(path) },
+		_buffer(std::max<Size>(buffer_size, 4096)),
+		_stream{ this }
+	{
+		_fd = open_file(_temp, false);
+		_failed = _fd < 0;
+		if (!_failed)
+			copy_mode(_path, _fd);
+		setp(_buffer.data(), _buffer.data() + _buffer.size());
+	}
+
+	AtomicFile::~AtomicFile()
+	{
+		discard();
+	}
+
+	void AtomicFile::write(const char* data, Size size)
+	{
+		xsputn(data, static_cast<std::streamsize>(size));
+	}
+
+	bool AtomicFile::commit()
+	{
+		if (_fd < 0)
+			return false;
+
+		bool ok = !_failed && _flush() && sync_file(_fd);
+		close_file(_fd);
+		_fd = -1;
+
+		std::error_code error;
+		if (ok)
+		{
+			filesystem::rename(_temp, _path, error);
+			ok = !error;
+		}
+
+		if (ok)
+		{
+			sync_directory(_path.parent_path());
+			resource::VirtualFolder::written(_path);
+		}
+		else filesystem::remove(_temp, error);
+		return ok;
+	}
+
+	void AtomicFile::discard()
+	{
+		if (_fd < 0)
+			return;
+
+		close_file(_fd);
+		_fd = -1;
+
+		std::error_code error;
+		filesystem::remove(_temp, error);
+	}
+
+	int AtomicFile::overflow(int c)
+	{
+		if (!_flush())
+			return traits_type::eof();
+
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize AtomicFile::xsputn(const char* data, std::streamsize size)
+	{
+		const Size count = static_cast<Size>(size);
+		if (count == 0)
+			return 0;
+		if (count <= static_cast<Size>(epptr() - pptr()))
+		{
+			std::memcpy(pptr(), data, count);
+			pbump(static_cast<int>(count));
+			return size;
+		}
+
+		// Larger than what is left: flush and write big blocks directly.
+		if (!_flush())
+			return 0;
+		if (count >= _buffer.size())
+		{
+			if (_fd < 0 || !write_all(_fd, data, count))
+				return _failed = true, 0;
+			return size;
+		}
+
+		std::memcpy(pptr(), data, count);
+		pbump(static_cast<int>(count));
+		return size;
+	}
+
+	int AtomicFile::sync()
+	{
+		return _flush() ? 0 : -1;
+	}
+
+	bool AtomicFile::_flush()
+	{
+		const Size pending = static_cast<Size>(pptr() - pbase());
+		if (pending > 0 && (_fd < 0 || !write_all(_fd, pbase(), pending)))
+			_failed = true;
+
+		setp(_buffer.data(), _buffer.data() + _buffer.size());
+		return !_failed;
+	}
+
+	Path temp_path(const Path& path)
+	{
+		static std::atomic<UInt64> counter{ 0 };
+		Path temp = path;
+		temp += ".tmp" + std::to_string(process_id()) + "_" + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+		return temp;
+	}
+
+	bool append_file(const Path& path, std::string_view data, bool sync)
+	{
+		const int fd = open_file(path, true);
+		if (fd < 0)
+			return false;
+
+		const bool ok = write_all(fd, data.data(), data.size()) && (!sync || sync_file(fd));
+		close_file(fd);
+		return ok;
+	}
+}
+
+namespace utils::json
+{
+	bool save(const Path& path, const Json& json)
+	{
+		AtomicFile file{ path };
+		try
+		{
+			file.stream() << json;
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+		return file.commit();
+	}
+
+	JsonJournal::JsonJournal(const Path& path, Size compact_after) :
+		_path{ path },
+		_journal{ path },
+		_state{},
+		_compact_after{ std::max<Size>(compact_after, 1) }
+	{
+		_journal += ".journal";
+	}
+
+	const Json& JsonJournal::load()
+	{
+		_state = nullptr;
+		_base_hash = 0;
+		_base_bytes = 0;
+		_journal_bytes = 0;
+		_entries = 0;
+
+		MappedFile base;
+		if (!base.open(_path))
+			return _state;
+
+		const std::string_view text{ base.data(), base.size() };
+		_base_hash = content_hash(text);
+		_base_bytes = text.size();
+		if (!text.empty())
+			_state = read(base);
+
+		std::ifstream input{ _journal, std::ios::in | std::ios::binary };
+		String line;
+		if (!std::getline(input, line) || input.eof())
+			return _state;
+
+		Size valid = line.size() + 1;
+		try
+		{
+			if (Json::parse(line).at("base").get<UInt64>() != _base_hash)
+				return _state;
+		}
+		catch (const std::exception&) { return _state; }
+
+		// A line without its newline, or one that does not parse, is a save
+		// that was cut short; everything before it is kept.
+		while (std::getline(input, line) && !input.eof())
+		{
+			try
+			{
+				const Json patch = Json::parse(line);
+				if (patch.is_array())
+					_state = _state.patch(patch);
+				else _state.merge_patch(patch);
+			}
+			catch (const std::exception&) { break; }
+
+			valid += line.size() + 1;
+			++_entries;
+		}
+
+		std::error_code error;
+		if (filesystem::file_size(_journal, error) != valid && !error)
+			filesystem::resize_file(_journal, valid, error);
+
+		_journal_bytes = _entries > 0 ? valid : 0;
+		return _state;
+	}
+
+	bool JsonJournal::save(const Json& state)
+	{
+		if (_base_bytes == 0)
+		{
+			_state = state;
+			return compact();
+		}
+
+		const Json patch = Json::diff(_state, state);
+		if (patch.empty())
+			return true;
+
+		if (!_append(patch))
+			return false;
+
+		_state = state;
+		if (_entries >= _compact_after || _journal_bytes > _base_bytes)
+			return compact();
+		return true;
+	}
+
+	bool JsonJournal::save(const Json::json_pointer& pointer, const Json& value)
+	{
+		// Only an existing value or a new object member journals as one
+		// operation that replays the same way; anything else is compacted.
+		const bool exists = !pointer.empty() && _state.contains(pointer);
+		const bool member = !pointer.empty() && _state.contains(pointer.parent_pointer()) && _state[pointer.parent_pointer()].is_object();
+		if (_base_bytes == 0 || !(exists || member))
+		{
+			_state[pointer] = value;
+			return compact();
+		}
+
+		const Json patch = Json::array({ { { "op", exists ? "replace" : "add" }, { "path", pointer.to_string() }, { "value", value } } });
+		if (!_append(patch))
+			return false;
+
+		_state[pointer] = value;
+		if (_entries >= _compact_after || _journal_bytes > _base_bytes)
+			return compact();
+		return true;
+	}
+
+	bool JsonJournal::merge(const Json& patch)
+	{
+		if (_base_bytes == 0 || !patch.is_object())
+		{
+			_state.merge_patch(patch);
+			return compact();
+		}
+
+		if (!_append(patch))
+			return false;
+
+		_state.merge_patch(patch);
+		if (_entries >= _compact_after || _journal_bytes > _base_bytes)
+			return compact();
+		return true;
+	}
+
+	bool JsonJournal::_append(const Json& patch)
+	{
+		String data;
+		if (_entries == 0)
+			data = Json{ { "base", _base_hash } }.dump() + '\n';
+		data += patch.dump();
+		data += '\n';
+
+		// Starting a fresh journal truncates whatever stale one was left.
+		if (_entries == 0)
+		{
+			std::error_code error;
+			filesystem::remove(_journal, error);
+		}
+
+		// A partial line left by a failed write would swallow the next entry,
+		// and load() would drop everything from there on; cut it off, or
+		// start over from a compacted file if even that fails.
+		if (!append_file(_journal, data))
+		{
+			std::error_code error;
+			if (_entries == 0)
+				filesystem::remove(_journal, error);
+			else filesystem::resize_file(_journal, _journal_bytes, error);
+			if (error)
+				compact();
+			return false;
+		}
+
+		_journal_bytes += data.size();
+		++_entries;
+		return true;
+	}
+
+	bool JsonJournal::compact()
+	{
+		const String text = _state.dump();
+
+		AtomicFile file{ _path };
+		file.write(text);
+		if (!file.commit())
+			return false;
+
+		// The new file's hash no longer matches the journal, so the journal
+		// is already dead; removing it just reclaims the space.
+		_base_hash = content_hash(text);
+		_base_bytes = text.size();
+		_journal_bytes = 0;
+		_entries = 0;
+
+		std::error_code error;
+		filesystem::remove(_journal, error);
+		return true;
+	}
+}
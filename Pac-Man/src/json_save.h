@@ -0,0 +1,138 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	// Writes a file under a temporary name next to its destination and
+	// renames it into place on commit(), so readers (and a crash halfway
+	// through) only ever see the old or the complete new contents. Output
+	// goes through one large user-space buffer; commit() flushes it and
+	// fsyncs the file before the rename. Dropping an uncommitted AtomicFile
+	// removes the temporary and leaves the destination untouched. A file
+	// replaced keeps its permissions; a new file committed below the root
+	// of a mounted VirtualFolder is added to its index.
+	class AtomicFile : private std::streambuf
+	{
+	public:
+		static constexpr Size default_buffer_size = 1024 * 1024;
+
+	private:
+		Path _path;
+		Path _temp;
+		int _fd = -1;
+		bool _failed = false;
+		std::vector<char> _buffer;
+		std::ostream _stream;
+
+	public:
+		explicit AtomicFile(const Path& path, Size buffer_size = default_buffer_size);
+		AtomicFile(const AtomicFile&) = delete;
+		AtomicFile(AtomicFile&&) = delete;
+		~AtomicFile();
+
+		AtomicFile& operator= (const AtomicFile&) = delete;
+		AtomicFile& operator= (AtomicFile&&) = delete;
+
+		inline bool is_open() const { return _fd >= 0; }
+		inline bool failed() const { return _failed; }
+
+		inline const Path& path() const { return _path; }
+
+		inline std::ostream& stream() { return _stream; }
+
+		void write(const char* data, Size size);
+		inline void write(std::string_view data) { write(data.data(), data.size()); }
+
+		// Returns false, and leaves the destination as it was, if anything
+		// failed since the file was opened.
+		bool commit();
+		void discard();
+
+	protected:
+		int overflow(int c) override;
+		std::streamsize xsputn(const char* data, std::streamsize size) override;
+		int sync() override;
+
+	private:
+		bool _flush();
+	};
+
+	// Name next to path for contents that are renamed into place once
+	// written. Unique across processes as well as threads: the process id
+	// and a process-wide counter.
+	Path temp_path(const Path& path);
+
+	// Appends data to a file, creating it if needed, and optionally fsyncs
+	// it before returning.
+	bool append_file(const Path& path, std::string_view data, bool sync = true);
+}
+
+namespace utils::json
+{
+	// Crash-safe counterparts of write(path, ...): serialize through an
+	// AtomicFile and report whether the new contents reached the disk.
+	bool save(const Path& path, const Json& json);
+	inline bool save(const String& path, const Json& json) { return save(Path{ path }, json); }
+	inline bool save(const Path& path, const JsonSerializable& js) { return save(path, js.serialize()); }
+	inline bool save(const String& path, const JsonSerializable& js) { return save(Path{ path }, js.serialize()); }
+
+	// State file that is cheap to save often. Instead of rewriting the file,
+	// save() appends a JSON Patch (RFC 6902) to <path>.journal: the one
+	// operation for save(pointer, value), or the diff from the last saved
+	// state for save(state), which is the slow path. merge() appends a merge
+	// patch (RFC 7396) the caller already has. compact() folds the
+	// journal back into an atomic rewrite once it holds compact_after
+	// entries or outgrows the file. The journal's first line records the
+	// hash of the file it applies to, so a journal left behind by an
+	// interrupted compaction is recognised as stale and ignored, and a torn
+	// last line is dropped.
+	class JsonJournal
+	{
+	public:
+		static constexpr Size default_compact_after = 64;
+
+	private:
+		Path _path;
+		Path _journal;
+		Json _state;
+		UInt64 _base_hash = 0;
+		Size _base_bytes = 0;
+		Size _journal_bytes = 0;
+		Size _entries = 0;
+		Size _compact_after;
+
+	public:
+		explicit JsonJournal(const Path& path, Size compact_after = default_compact_after);
+
+		// Reads the file and replays the journal on top of it. A missing
+		// file yields a null state.
+		const Json& load();
+
+		// Journals the JSON Patch from the last saved state. The diff walks
+		// both documents in full, so on a large state this costs more than a
+		// full atomic save(path, json); callers that know what changed should
+		// use save(pointer, value) or merge() instead, which skip the diff.
+		bool save(const Json& state);
+		inline bool save(const JsonSerializable& js) { return save(js.serialize()); }
+
+		// Sets the value at pointer, whose parent must exist, and journals
+		// that one operation.
+		bool save(const Json::json_pointer& pointer, const Json& value);
+
+		// Applies a merge patch to the state in place and journals it. A patch
+		// that is not an object replaces the whole state and is compacted.
+		bool merge(const Json& patch);
+
+		bool compact();
+
+		inline const Json& state() const { return _state; }
+		inline Size entries() const { return _entries; }
+		inline Size journal_bytes() const { return _journal_bytes; }
+		inline const Path& path() const { return _path; }
+		inline const Path& journal_path() const { return _journal; }
+
+	private:
+		bool _append(const Json& patch);
+	};
+}
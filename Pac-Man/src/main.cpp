@@ -1,6 +1,16 @@
 #include "common.h"
+#include "resource_vfs.h"
 
 int main(int argc, char** argv)
 {
+	// data/ is served from data.pak when a shipped build has one, with any
+	// loose file in data/ filling in what it lacks and mods/ overriding
+	// both. Without the pack, loose files alone are used.
+	resource::VirtualFolder data;
+	data.addFolder("data"_p, 0);
+	data.addPack("data.pak"_p, 1);
+	data.addFolder("mods"_p, 2);
+	resource::VirtualFolder::mount(std::move(data));
+
 	return 0;
 }
@@ -0,0 +1,68 @@
+#include "resource_async.h"
+
+namespace resource
+{
+	AsyncLoader::AsyncLoader(utils::ThreadPool& pool) :
+		_pool{ pool },
+		_mutex{},
+		_signal{},
+		_completions{},
+		_ready{}
+	{}
+
+	AsyncLoader::~AsyncLoader()
+	{
+		wait();
+	}
+
+	Size AsyncLoader::update(std::chrono::microseconds budget)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		{
+			std::lock_guard lock{ _mutex };
+			std::move(_completions.begin(), _completions.end(), std::back_inserter(_ready));
+			_completions.clear();
+		}
+
+		Size count = 0;
+		while (!_ready.empty())
+		{
+			const Function<void()> step = std::move(_ready.front());
+			_ready.pop_front();
+			step();
+			++count;
+			if (std::chrono::steady_clock::now() - start >= budget)
+				break;
+		}
+		return count;
+	}
+
+	void AsyncLoader::_post(Function<void()> step)
+	{
+		std::lock_guard lock{ _mutex };
+		_completions.push_back(std::move(step));
+		_signal.notify_one();
+	}
+
+	void AsyncLoader::_finished()
+	{
+		// Under the mutex, so wait() cannot miss it between checking and
+		// sleeping, nor return and destroy the loader before it is done.
+		std::lock_guard lock{ _mutex };
+		_pending.fetch_sub(1, std::memory_order_acq_rel);
+		_signal.notify_one();
+	}
+
+	void AsyncLoader::wait()
+	{
+		while (pending() > 0)
+		{
+			if (update() > 0)
+				continue;
+
+			std::unique_lock lock{ _mutex };
+			_signal.wait(lock, [this] { return pending() == 0 || !_completions.empty(); });
+		}
+	}
+}
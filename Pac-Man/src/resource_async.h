@@ -0,0 +1,283 @@
+#pragma once
+
+#include "resource_cache.h"
+#include "thread_pool.h"
+
+#include <condition_variable>
+#include <deque>
+
+namespace resource
+{
+	// Result of an asynchronous load. ready() never blocks; get() waits and
+	// rethrows whatever the load threw. The value is nullptr if the file
+	// could not be opened or decoded, as with ResourceCache::get().
+	template<typename _Ty>
+	class LoadFuture
+	{
+	public:
+		using Future = std::shared_future<std::shared_ptr<const _Ty>>;
+
+	private:
+		Future _future;
+
+	public:
+		LoadFuture() = default;
+		LoadFuture(const LoadFuture&) = default;
+		LoadFuture(LoadFuture&&) noexcept = default;
+		~LoadFuture() = default;
+
+		inline explicit LoadFuture(Future future) : _future{ std::move(future) } {}
+
+		LoadFuture& operator= (const LoadFuture&) = default;
+		LoadFuture& operator= (LoadFuture&&) noexcept = default;
+
+		inline bool valid() const { return _future.valid(); }
+		inline bool ready() const { return _future.valid() && _future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready; }
+
+		inline void wait() const { _future.wait(); }
+		inline std::shared_ptr<const _Ty> get() const { return _future.get(); }
+
+		inline const Future& future() const { return _future; }
+
+	public:
+		static LoadFuture completed(std::shared_ptr<const _Ty> value)
+		{
+			std::promise<std::shared_ptr<const _Ty>> promise;
+			promise.set_value(std::move(value));
+			return LoadFuture{ promise.get_future().share() };
+		}
+	};
+
+
+
+	// How a resource is split between a worker and the main thread.
+	// decode() runs on a worker; types that need the main thread for their
+	// last step (a GL context, for textures) also have finish(), which turns
+	// the decoded data into the resource from AsyncLoader::update(). By
+	// default the whole synchronous ResourceLoader runs on the worker.
+	template<typename _Ty>
+	struct AsyncResourceLoader
+	{
+		static std::shared_ptr<_Ty> decode(const Folder& folder, const Path& path, Size& bytes)
+		{
+			return ResourceLoader<_Ty>::load(folder, path, bytes);
+		}
+	};
+
+	template<>
+	struct AsyncResourceLoader<sf::Image>
+	{
+		static std::shared_ptr<sf::Image> decode(const Folder& folder, const Path& path, Size& bytes)
+		{
+			FileView view;
+			auto image = std::make_shared<sf::Image>();
+			if (!folder.openView(path, view) || !image->loadFromMemory(view.data.data(), view.data.size()))
+				return nullptr;
+
+			bytes = static_cast<Size>(image->getSize().x) * image->getSize().y * 4;
+			return image;
+		}
+	};
+
+	template<>
+	struct AsyncResourceLoader<sf::Texture>
+	{
+		static std::shared_ptr<sf::Image> decode(const Folder& folder, const Path& path, Size& bytes)
+		{
+			return AsyncResourceLoader<sf::Image>::decode(folder, path, bytes);
+		}
+
+		static std::shared_ptr<sf::Texture> finish(const sf::Image& image)
+		{
+			auto texture = std::make_shared<sf::Texture>();
+			if (!texture->loadFromImage(image))
+				return nullptr;
+			return texture;
+		}
+	};
+
+	template<typename _Ty>
+	concept MainThreadFinish = requires { &AsyncResourceLoader<_Ty>::finish; };
+
+
+
+	// Loads resources on a thread pool. Reading and decoding happen on the
+	// workers; the main-thread steps (texture uploads) are queued and run by
+	// update(), which the game calls once per frame with a time budget, so a
+	// level can stream in while frames keep their pace. A texture's future
+	// only becomes ready through update(), so waiting on it from the main
+	// thread without calling update() (or wait()) never returns. The loader
+	// must outlive its pending loads; the destructor waits for them.
+	class AsyncLoader
+	{
+	public:
+		template<typename _Ty>
+		using Callback = Function<void(const std::shared_ptr<const _Ty>&, Size)>;
+
+		static constexpr std::chrono::microseconds default_budget{ 2000 };
+
+	private:
+		utils::ThreadPool& _pool;
+		std::atomic<Size> _pending{ 0 };
+
+		// Workers append main-thread steps under the mutex and never wait for
+		// the main thread, however many are queued; update() moves them to
+		// _ready, which only the main thread touches. _signal wakes wait()
+		// when a step is posted or a load finishes.
+		std::mutex _mutex;
+		std::condition_variable _signal;
+		std::vector<Function<void()>> _completions;
+		std::deque<Function<void()>> _ready;
+
+	public:
+		explicit AsyncLoader(utils::ThreadPool& pool = utils::ThreadPool::shared());
+		AsyncLoader(const AsyncLoader&) = delete;
+		AsyncLoader(AsyncLoader&&) = delete;
+		~AsyncLoader();
+
+		AsyncLoader& operator= (const AsyncLoader&) = delete;
+		AsyncLoader& operator= (AsyncLoader&&) = delete;
+
+		// Starts loading path from folder. done, if given, receives the
+		// resource (nullptr if it failed or threw) and its size before the
+		// future becomes ready, on a worker or, for main-thread types, in
+		// update().
+		template<typename _Ty>
+		LoadFuture<_Ty> load(const Folder& folder, const Path& path, Callback<_Ty> done = {})
+		{
+			using Promise = std::promise<std::shared_ptr<const _Ty>>;
+
+			const auto promise = std::make_shared<Promise>();
+			LoadFuture<_Ty> future{ promise->get_future().share() };
+
+			_pending.fetch_add(1, std::memory_order_relaxed);
+			_pool.submit([this, folder, path, promise, done = std::move(done)] {
+				try
+				{
+					Size bytes = 0;
+					auto decoded = AsyncResourceLoader<_Ty>::decode(folder, path, bytes);
+					if constexpr (MainThreadFinish<_Ty>)
+					{
+						if (!decoded)
+							return _complete<_Ty>(*promise, done, nullptr, 0);
+
+						_post([this, promise, done, decoded = std::move(decoded), bytes] {
+							try { _complete<_Ty>(*promise, done, AsyncResourceLoader<_Ty>::finish(*decoded), bytes); }
+							catch (...) { _fail<_Ty>(*promise, done); }
+						});
+					}
+					else _complete<_Ty>(*promise, done, std::move(decoded), bytes);
+				}
+				catch (...) { _fail<_Ty>(*promise, done); }
+			});
+			return future;
+		}
+
+		// Main thread only. Runs queued main-thread steps until the queue is
+		// empty or budget has been spent (at least one runs), and returns how
+		// many ran.
+		Size update(std::chrono::microseconds budget = default_budget);
+
+		// Main thread only. Runs update() until nothing is pending, for
+		// loading screens and shutdown, sleeping while the workers have
+		// nothing for it.
+		void wait();
+
+		// Loads started and not finished yet.
+		inline Size pending() const { return _pending.load(std::memory_order_acquire); }
+
+	private:
+		void _post(Function<void()> step);
+		void _finished();
+
+		template<typename _Ty>
+		void _complete(std::promise<std::shared_ptr<const _Ty>>& promise, const Callback<_Ty>& done, std::shared_ptr<const _Ty> resource, Size bytes)
+		{
+			if (done)
+				done(resource, resource ? bytes : 0);
+			promise.set_value(std::move(resource));
+			_finished();
+		}
+
+		// Called from a catch block; done sees the failure as a nullptr.
+		template<typename _Ty>
+		void _fail(std::promise<std::shared_ptr<const _Ty>>& promise, const Callback<_Ty>& done)
+		{
+			const std::exception_ptr error = std::current_exception();
+			if (done)
+			{
+				try { done(nullptr, 0); }
+				catch (...) {}
+			}
+			promise.set_exception(error);
+			_finished();
+		}
+	};
+
+
+
+	template<CachedResource _Ty>
+	LoadFuture<_Ty> ResourceCache::getAsync(const Path& path, AsyncLoader& loader)
+	{
+		const String key = keyOf(path);
+		std::lock_guard lock{ _mutex };
+
+		const Store<_Ty>& store = std::get<Store<_Ty>>(_stores);
+		if (const auto it = store.find(key); it != store.end())
+			return ++_stats.hits, LoadFuture<_Ty>::completed(it->second.resource);
+
+		Loading<_Ty>& loading = std::get<Loading<_Ty>>(_loading);
+		if (const auto it = loading.find(key); it != loading.end())
+			return ++_stats.hits, LoadFuture<_Ty>{ it->second };
+
+		// The callback takes the lock, so it cannot store the result before
+		// the load is registered here, even if it finishes right away.
+		LoadFuture<_Ty> future = loader.load<_Ty>(_folder, path, [this, key](const Handle<_Ty>& resource, Size bytes) {
+			std::lock_guard lock{ _mutex };
+			std::get<Loading<_Ty>>(_loading).erase(key);
+			_insert<_Ty>(key, resource, bytes);
+		});
+		loading.emplace(key, future.future());
+		return future;
+	}
+
+	template<ReloadableResource _Ty>
+	bool ResourceCache::reload(const Path& path, AsyncLoader& loader)
+	{
+		const String key = keyOf(path);
+		UInt64 version;
+		{
+			std::lock_guard lock{ _mutex };
+			if (!std::get<Store<_Ty>>(_stores).contains(key))
+				return false;
+			version = ++_reload_sequence;
+		}
+
+		loader.load<_Ty>(_folder, path, [this, key, version](const Handle<_Ty>& fresh, Size bytes) {
+			if (!fresh)
+				return;
+
+			std::lock_guard lock{ _mutex };
+			_swaps.push_back([this, key, version, fresh, bytes] {
+				Store<_Ty>& store = std::get<Store<_Ty>>(_stores);
+				const auto it = store.find(key);
+				if (it == store.end() || it->second.version > version)
+					return false;
+
+				// Both objects were created mutable by their loaders.
+				_Ty& current = const_cast<_Ty&>(*it->second.resource);
+				_Ty& next = const_cast<_Ty&>(*fresh);
+				if constexpr (requires { current.swap(next); })
+					current.swap(next);
+				else current = next;
+
+				_stats.bytes = _stats.bytes - it->second.bytes + bytes;
+				it->second.bytes = bytes;
+				it->second.version = version;
+				++_stats.reloads;
+				return true;
+			});
+		});
+		return true;
+	}
+}
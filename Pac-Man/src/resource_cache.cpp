@@ -0,0 +1,102 @@
+#include "resource_cache.h"
+
+namespace
+{
+	// Rough heap footprint of a Json value beyond its own node: std::map
+	// nodes carry four words of tree bookkeeping, and strings only allocate
+	// once they outgrow the small-string buffer.
+	constexpr Size map_node_overhead = 4 * sizeof(void*);
+
+	inline Size string_heap(const String& str)
+	{
+		return str.capacity() > String{}.capacity() ? str.capacity() + 1 : 0;
+	}
+
+	Size heap_size(const Json& json)
+	{
+		switch (json.type())
+		{
+			case Json::value_t::object: {
+				const auto& object = json.get_ref<const Json::object_t&>();
+				Size bytes = sizeof(Json::object_t);
+				for (const auto& [key, value] : object)
+					bytes += map_node_overhead + sizeof(String) + sizeof(Json) + string_heap(key) + heap_size(value);
+				return bytes;
+			}
+
+			case Json::value_t::array: {
+				const auto& array = json.get_ref<const Json::array_t&>();
+				Size bytes = sizeof(Json::array_t) + array.capacity() * sizeof(Json);
+				for (const Json& value : array)
+					bytes += heap_size(value);
+				return bytes;
+			}
+
+			case Json::value_t::string:
+				return sizeof(String) + string_heap(json.get_ref<const String&>());
+
+			default:
+				return 0;
+		}
+	}
+}
+
+namespace resource
+{
+	std::shared_ptr<Json> ResourceLoader<Json>::load(const Folder& folder, const Path& path, Size& bytes)
+	{
+		auto json = std::make_shared<Json>();
+		if (!folder.readJson(path, *json))
+			return nullptr;
+
+		bytes = sizeof(Json) + heap_size(*json);
+		return json;
+	}
+
+
+
+	ResourceCache::ResourceCache(const Folder& folder) :
+		_folder{ folder },
+		_stores{},
+		_loading{},
+		_swaps{},
+		_mutex{},
+		_stats{}
+	{}
+
+	Size ResourceCache::unloadUnused()
+	{
+		std::lock_guard lock{ _mutex };
+		return std::apply([this](auto&... stores) { return (_unloadUnused(stores) + ...); }, _stores);
+	}
+
+	Size ResourceCache::applyReloads()
+	{
+		std::lock_guard lock{ _mutex };
+		Size count = 0;
+		for (const Function<bool()>& swap : _swaps)
+			count += swap() ? 1 : 0;
+		_swaps.clear();
+		return count;
+	}
+
+	ResourceCache::Stats ResourceCache::stats() const
+	{
+		std::lock_guard lock{ _mutex };
+		return _stats;
+	}
+
+	void ResourceCache::resetStats()
+	{
+		std::lock_guard lock{ _mutex };
+		_stats.hits = 0;
+		_stats.misses = 0;
+		_stats.failures = 0;
+		_stats.reloads = 0;
+	}
+
+	String ResourceCache::keyOf(const Path& path) const
+	{
+		return _folder.pathOf(path).lexically_normal().generic_string();
+	}
+}
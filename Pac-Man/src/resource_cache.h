@@ -0,0 +1,302 @@
+#pragma once
+
+#include "common.h"
+
+#include <future>
+#include <tuple>
+
+namespace resource
+{
+	// How the ResourceCache loads each resource type from a Folder. load()
+	// returns nullptr when the file cannot be opened or decoded, and sets
+	// bytes to the memory the loaded resource holds.
+	template<typename _Ty>
+	struct ResourceLoader;
+
+	template<>
+	struct ResourceLoader<sf::Texture>
+	{
+		// Counts the decoded RGBA pixels, which is what the texture occupies
+		// on the GPU.
+		static std::shared_ptr<sf::Texture> load(const Folder& folder, const Path& path, Size& bytes)
+		{
+			FileView view;
+			auto texture = std::make_shared<sf::Texture>();
+			if (!folder.openView(path, view) || !texture->loadFromMemory(view.data.data(), view.data.size()))
+				return nullptr;
+
+			bytes = static_cast<Size>(texture->getSize().x) * texture->getSize().y * 4;
+			return texture;
+		}
+	};
+
+	template<>
+	struct ResourceLoader<sf::SoundBuffer>
+	{
+		static std::shared_ptr<sf::SoundBuffer> load(const Folder& folder, const Path& path, Size& bytes)
+		{
+			FileView view;
+			auto sound = std::make_shared<sf::SoundBuffer>();
+			if (!folder.openView(path, view) || !sound->loadFromMemory(view.data.data(), view.data.size()))
+				return nullptr;
+
+			bytes = static_cast<Size>(sound->getSampleCount()) * sizeof(sf::Int16);
+			return sound;
+		}
+	};
+
+	template<>
+	struct ResourceLoader<sf::Font>
+	{
+		// sf::Font reads glyphs from its source on demand, so the file stays
+		// open for as long as any handle to the font exists. Only the file
+		// is counted, not the glyph pages rendered later.
+		struct Holder
+		{
+			FileView view;
+			sf::Font font;
+		};
+
+		static std::shared_ptr<sf::Font> load(const Folder& folder, const Path& path, Size& bytes)
+		{
+			auto holder = std::make_shared<Holder>();
+			if (!folder.openView(path, holder->view) || !holder->font.loadFromMemory(holder->view.data.data(), holder->view.data.size()))
+				return nullptr;
+
+			bytes = holder->view.data.size();
+			return { holder, &holder->font };
+		}
+	};
+
+	template<>
+	struct ResourceLoader<Json>
+	{
+		// Goes through Folder::readJson, so the active JsonCache is used.
+		// The size is an estimate of the heap held by the document.
+		static std::shared_ptr<Json> load(const Folder& folder, const Path& path, Size& bytes);
+	};
+
+	template<typename _Ty>
+	class LoadFuture;
+
+	class AsyncLoader;
+
+	template<typename _Ty>
+	concept CachedResource = requires(const Folder& folder, const Path& path, Size& bytes) {
+		{ ResourceLoader<_Ty>::load(folder, path, bytes) } -> std::same_as<std::shared_ptr<_Ty>>;
+	};
+
+	// Resources whose contents can be replaced in place by a reload, so
+	// handles already given out see the new data. Fonts are left out: a
+	// font keeps reading glyphs from the memory it was loaded from, which
+	// belongs to the handle it was loaded into.
+	template<typename _Ty>
+	concept ReloadableResource = CachedResource<_Ty> && !std::same_as<_Ty, sf::Font>;
+
+
+
+	// Loads textures, sound buffers, fonts and JSON documents from a Folder
+	// once and hands out shared handles to them, so everything that asks for
+	// the same file shares one copy. Entries are keyed by their normalized
+	// path and stay resident after the last handle goes away, until
+	// unload() or unloadUnused() drops them; an entry that still has
+	// handles outside the cache is never dropped. All members are thread
+	// safe. get() loads outside the lock, so two threads missing on the
+	// same file at once may both load it; the first one stored wins.
+	class ResourceCache
+	{
+	public:
+		template<CachedResource _Ty>
+		using Handle = std::shared_ptr<const _Ty>;
+
+		struct Stats
+		{
+			Size hits = 0;
+			Size misses = 0;
+			Size failures = 0;
+			Size entries = 0;
+			Size bytes = 0;
+			Size reloads = 0;
+		};
+
+	private:
+		template<typename _Ty>
+		struct Entry
+		{
+			std::shared_ptr<const _Ty> resource;
+			Size bytes;
+			UInt64 version = 0;
+		};
+
+		template<typename _Ty>
+		using Store = std::unordered_map<String, Entry<_Ty>>;
+
+		template<typename _Ty>
+		using Loading = std::unordered_map<String, std::shared_future<std::shared_ptr<const _Ty>>>;
+
+	private:
+		Folder _folder;
+		std::tuple<Store<sf::Texture>, Store<sf::SoundBuffer>, Store<sf::Font>, Store<Json>> _stores;
+		std::tuple<Loading<sf::Texture>, Loading<sf::SoundBuffer>, Loading<sf::Font>, Loading<Json>> _loading;
+		std::vector<Function<bool()>> _swaps;
+		UInt64 _reload_sequence = 0;
+		mutable std::mutex _mutex;
+		Stats _stats;
+
+	public:
+		explicit ResourceCache(const Folder& folder = root);
+		ResourceCache(const ResourceCache&) = delete;
+		ResourceCache(ResourceCache&&) = delete;
+		~ResourceCache() = default;
+
+		ResourceCache& operator= (const ResourceCache&) = delete;
+		ResourceCache& operator= (ResourceCache&&) = delete;
+
+		// Handle to the resource at path (relative to the folder), loading it
+		// on first use. Returns nullptr if it cannot be loaded; failures are
+		// not cached, so a later call tries again.
+		template<CachedResource _Ty>
+		Handle<_Ty> get(const Path& path)
+		{
+			const String key = keyOf(path);
+			{
+				std::lock_guard lock{ _mutex };
+				const Store<_Ty>& store = std::get<Store<_Ty>>(_stores);
+				if (const auto it = store.find(key); it != store.end())
+					return ++_stats.hits, it->second.resource;
+			}
+
+			Size bytes = 0;
+			std::shared_ptr<const _Ty> resource = ResourceLoader<_Ty>::load(_folder, path, bytes);
+
+			std::lock_guard lock{ _mutex };
+			return _insert<_Ty>(key, std::move(resource), bytes);
+		}
+
+		// Same as get(), but reading and decoding happen on loader's workers
+		// (see resource_async.h). Requests for a file that is already being
+		// loaded share that load. The loader has to finish its pending
+		// loads before the cache is destroyed.
+		template<CachedResource _Ty>
+		LoadFuture<_Ty> getAsync(const Path& path, AsyncLoader& loader);
+
+		template<CachedResource _Ty>
+		inline Handle<_Ty> get(const String& filename) { return get<_Ty>(Path{ filename }); }
+
+		template<CachedResource _Ty>
+		inline Handle<_Ty> get(const char* filename) { return get<_Ty>(Path{ filename }); }
+
+		inline Handle<sf::Texture> texture(const Path& path) { return get<sf::Texture>(path); }
+		inline Handle<sf::SoundBuffer> sound(const Path& path) { return get<sf::SoundBuffer>(path); }
+		inline Handle<sf::Font> font(const Path& path) { return get<sf::Font>(path); }
+		inline Handle<Json> json(const Path& path) { return get<Json>(path); }
+
+		template<CachedResource _Ty>
+		bool contains(const Path& path) const
+		{
+			const String key = keyOf(path);
+			std::lock_guard lock{ _mutex };
+			return std::get<Store<_Ty>>(_stores).contains(key);
+		}
+
+		// Number of handles to the entry held outside the cache; 0 if it is
+		// unused or not loaded.
+		template<CachedResource _Ty>
+		Size references(const Path& path) const
+		{
+			const String key = keyOf(path);
+			std::lock_guard lock{ _mutex };
+			const Store<_Ty>& store = std::get<Store<_Ty>>(_stores);
+			const auto it = store.find(key);
+			return it != store.end() ? static_cast<Size>(it->second.resource.use_count() - 1) : 0;
+		}
+
+		// Drops the entry if nothing outside the cache references it.
+		template<CachedResource _Ty>
+		bool unload(const Path& path)
+		{
+			const String key = keyOf(path);
+			std::lock_guard lock{ _mutex };
+			Store<_Ty>& store = std::get<Store<_Ty>>(_stores);
+			const auto it = store.find(key);
+			if (it == store.end() || it->second.resource.use_count() > 1)
+				return false;
+
+			_erase(store, it);
+			return true;
+		}
+
+		// Drops every unreferenced entry of one type, or of all types, and
+		// returns how many were dropped.
+		template<CachedResource _Ty>
+		Size unloadUnused()
+		{
+			std::lock_guard lock{ _mutex };
+			return _unloadUnused(std::get<Store<_Ty>>(_stores));
+		}
+
+		Size unloadUnused();
+
+		// Reloads a resident entry on loader's workers (see resource_async.h)
+		// and stages the result; applyReloads() then swaps the new contents
+		// into the existing object, so every handle sees them. Returns false
+		// if the entry is not resident. A file that no longer loads leaves the
+		// old contents in place, and of overlapping reloads of one entry the
+		// one started last wins. Reloading a sound buffer stops the sounds
+		// playing it.
+		template<ReloadableResource _Ty>
+		bool reload(const Path& path, AsyncLoader& loader);
+
+		// Main thread, between frames: applies the reloads finished so far
+		// and returns how many there were. References into a resource (not
+		// the handle itself) must not be held across this call.
+		Size applyReloads();
+
+		Stats stats() const;
+		void resetStats();
+
+		String keyOf(const Path& path) const;
+
+		inline const Folder& folder() const { return _folder; }
+
+	private:
+		// Stores a freshly loaded resource; the caller holds the lock. If
+		// another load of the same key got there first, its copy is kept.
+		template<typename _Ty>
+		Handle<_Ty> _insert(const String& key, std::shared_ptr<const _Ty> resource, Size bytes)
+		{
+			if (!resource)
+				return ++_stats.failures, nullptr;
+
+			auto [it, inserted] = std::get<Store<_Ty>>(_stores).try_emplace(key, Entry<_Ty>{ std::move(resource), bytes });
+			if (!inserted)
+				return ++_stats.hits, it->second.resource;
+
+			++_stats.misses;
+			++_stats.entries;
+			_stats.bytes += bytes;
+			return it->second.resource;
+		}
+
+		template<typename _Ty>
+		typename Store<_Ty>::iterator _erase(Store<_Ty>& store, typename Store<_Ty>::iterator it)
+		{
+			_stats.bytes -= it->second.bytes;
+			--_stats.entries;
+			return store.erase(it);
+		}
+
+		template<typename _Ty>
+		Size _unloadUnused(Store<_Ty>& store)
+		{
+			Size count = 0;
+			for (auto it = store.begin(); it != store.end();)
+			{
+				if (it->second.resource.use_count() > 1)
+					++it;
+				else it = _erase(store, it), ++count;
+			}
+			return count;
+		}
+	};
+}
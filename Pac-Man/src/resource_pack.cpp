@@ -0,0 +1,332 @@
+#include "resource_pack.h"
+
+#include <bit>
+
+namespace
+{
+	constexpr char pack_magic[4] = { 'P', 'P', 'A', 'K' };
+	constexpr UInt32 empty_slot = 0xffffffffu;
+
+	struct PackHeader
+	{
+		char magic[4];
+		UInt32 version;
+		UInt32 alignment;
+		UInt32 entry_count;
+		UInt32 slot_count;
+		UInt32 reserved;
+		UInt64 blob_offset;
+		UInt64 archive_size;
+	};
+
+	UInt64 name_hash(std::string_view name)
+	{
+		UInt64 hash = 0xcbf29ce484222325ull;
+		for (const char c : name)
+			hash = (hash ^ static_cast<UInt8>(c)) * 0x100000001b3ull;
+		return hash;
+	}
+
+	inline UInt64 align_up(UInt64 value, UInt64 alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+	std::mutex mounted_pack_mutex;
+	std::shared_ptr<const resource::Pack> mounted_pack;
+}
+
+namespace resource
+{
+	String entryName(const Path& path)
+	{
+		String name = path.lexically_normal().generic_string();
+		if (name == ".")
+			name.clear();
+		else if (!name.empty() && name.back() == '/')
+			name.pop_back();
+		return name;
+	}
+
+	bool entryName(const String& root, const Path& path, String& name)
+	{
+		name = entryName(path);
+		if (root.empty())
+			return !name.empty() && !name.starts_with("../") && name != "..";
+
+		if (name.size() <= root.size() || name[root.size()] != '/' || !name.starts_with(root))
+			return false;
+
+		name.erase(0, root.size() + 1);
+		return true;
+	}
+
+
+
+	struct Pack::Entry
+	{
+		UInt64 hash;
+		UInt64 offset;
+		UInt64 size;
+		UInt32 name_offset;
+		UInt32 name_size;
+	};
+
+	bool Pack::open(const Path& archive, const Path& root)
+	{
+		close();
+
+		auto file = std::make_shared<utils::MappedFile>();
+		if (!file->open(archive) || file->size() < sizeof(PackHeader))
+			return false;
+
+		PackHeader header;
+		std::memcpy(&header, file->data(), sizeof(header));
+
+		const UInt64 size = file->size();
+		const UInt64 entries_offset = sizeof(PackHeader);
+		const UInt64 slots_offset = entries_offset + UInt64{ header.entry_count } * sizeof(Entry);
+		const UInt64 names_offset = slots_offset + UInt64{ header.slot_count } * sizeof(UInt32);
+		if (std::memcmp(header.magic, pack_magic, sizeof(pack_magic)) != 0 ||
+			header.version != version ||
+			header.archive_size != size ||
+			!std::has_single_bit(header.slot_count) ||
+			header.slot_count <= header.entry_count ||
+			names_offset > header.blob_offset ||
+			header.blob_offset > size)
+			return false;
+
+		const Entry* entries = reinterpret_cast<const Entry*>(file->data() + entries_offset);
+		const UInt32* slots = reinterpret_cast<const UInt32*>(file->data() + slots_offset);
+		const UInt64 names_size = header.blob_offset - names_offset;
+
+		for (UInt32 i = 0; i < header.entry_count; ++i)
+		{
+			const Entry& entry = entries[i];
+			if (entry.offset < header.blob_offset || entry.offset > size || entry.size > size - entry.offset ||
+				entry.name_offset > names_size || entry.name_size > names_size - entry.name_offset)
+				return false;
+		}
+
+		// Every probe has to reach an empty slot, or a lookup would not end.
+		UInt32 used = 0;
+		for (UInt32 i = 0; i < header.slot_count; ++i)
+		{
+			if (slots[i] == empty_slot)
+				continue;
+			if (slots[i] >= header.entry_count)
+				return false;
+			++used;
+		}
+		if (used != header.entry_count)
+			return false;
+
+		_file = std::move(file);
+		_entries = entries;
+		_slots = slots;
+		_names = _file->data() + names_offset;
+		_count = header.entry_count;
+		_slot_mask = header.slot_count - 1;
+		_root = entryName(root);
+		return true;
+	}
+
+	void Pack::close()
+	{
+		_file.reset();
+		_entries = nullptr;
+		_slots = nullptr;
+		_names = nullptr;
+		_count = 0;
+		_slot_mask = 0;
+		_root.clear();
+	}
+
+	bool Pack::find(std::string_view name, std::string_view& data) const
+	{
+		if (!_file)
+			return false;
+
+		const UInt64 hash = name_hash(name);
+		for (UInt32 slot = static_cast<UInt32>(hash) & _slot_mask; _slots[slot] != empty_slot; slot = (slot + 1) & _slot_mask)
+		{
+			const Entry& entry = _entries[_slots[slot]];
+			if (entry.hash == hash && name == std::string_view{ _names + entry.name_offset, entry.name_size })
+			{
+				data = { _file->data() + entry.offset, static_cast<Size>(entry.size) };
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string_view Pack::nameOf(Offset index) const
+	{
+		const Entry& entry = _entries[index];
+		return { _names + entry.name_offset, entry.name_size };
+	}
+
+	std::string_view Pack::dataOf(Offset index) const
+	{
+		const Entry& entry = _entries[index];
+		return { _file->data() + entry.offset, static_cast<Size>(entry.size) };
+	}
+
+	bool Pack::relative(const Path& path, String& name) const { return entryName(_root, path, name); }
+
+	bool Pack::mount(const Path& archive, const Path& root)
+	{
+		auto pack = std::make_shared<Pack>();
+		if (!pack->open(archive, root))
+			return false;
+
+		std::lock_guard lock{ mounted_pack_mutex };
+		mounted_pack = std::move(pack);
+		return true;
+	}
+
+	void Pack::unmount()
+	{
+		std::lock_guard lock{ mounted_pack_mutex };
+		mounted_pack.reset();
+	}
+
+	std::shared_ptr<const Pack> Pack::mounted()
+	{
+		std::lock_guard lock{ mounted_pack_mutex };
+		return mounted_pack;
+	}
+
+
+
+	PackWriter::PackWriter(const Path& archive, Size alignment) :
+		_archive{ archive },
+		_alignment{ std::bit_ceil(std::max<Size>(alignment, 1)) },
+		_sources{},
+		_names{}
+	{}
+
+	void PackWriter::add(const String& name, String data)
+	{
+		Source& source = _source(name);
+		source.path.clear();
+		source.size = data.size();
+		source.data = std::move(data);
+	}
+
+	bool PackWriter::addFile(const String& name, const Path& path)
+	{
+		std::error_code error;
+		const UInt64 size = static_cast<UInt64>(filesystem::file_size(path, error));
+		if (error)
+			return false;
+
+		Source& source = _source(name);
+		source.path = path;
+		source.data.clear();
+		source.size = size;
+		return true;
+	}
+
+	Size PackWriter::addFolder(const Path& directory)
+	{
+		Size count = 0;
+		std::error_code error;
+		for (auto it = filesystem::recursive_directory_iterator{ directory, error }; !error && it != filesystem::recursive_directory_iterator{}; it.increment(error))
+		{
+			// An archive written into the folder it packs must not pack itself.
+			std::error_code ignored;
+			if (!it->is_regular_file(error) || filesystem::equivalent(it->path(), _archive, ignored))
+				continue;
+			if (addFile(it->path().lexically_relative(directory).generic_string(), it->path()))
+				++count;
+		}
+		return count;
+	}
+
+	bool PackWriter::commit()
+	{
+		// Sorted by name, so files of one directory end up next to each other.
+		std::vector<const Source*> sources;
+		sources.reserve(_sources.size());
+		for (const Source& source : _sources)
+			sources.push_back(&source);
+		std::sort(sources.begin(), sources.end(), [](const Source* left, const Source* right) { return left->name < right->name; });
+
+		const UInt32 count = static_cast<UInt32>(sources.size());
+		const UInt32 slot_count = std::bit_ceil(std::max<UInt32>(count * 2, 2));
+
+		std::vector<Pack::Entry> entries(count);
+		std::vector<UInt32> slots(slot_count, empty_slot);
+		String names;
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			Pack::Entry& entry = entries[i];
+			entry.hash = name_hash(sources[i]->name);
+			entry.size = sources[i]->size;
+			entry.name_offset = static_cast<UInt32>(names.size());
+			entry.name_size = static_cast<UInt32>(sources[i]->name.size());
+			names += sources[i]->name;
+
+			UInt32 slot = static_cast<UInt32>(entry.hash) & (slot_count - 1);
+			while (slots[slot] != empty_slot)
+				slot = (slot + 1) & (slot_count - 1);
+			slots[slot] = i;
+		}
+
+		const UInt64 names_offset = sizeof(PackHeader) + entries.size() * sizeof(Pack::Entry) + slots.size() * sizeof(UInt32);
+		UInt64 offset = align_up(names_offset + names.size(), _alignment);
+
+		PackHeader header{};
+		std::memcpy(header.magic, pack_magic, sizeof(pack_magic));
+		header.version = Pack::version;
+		header.alignment = static_cast<UInt32>(_alignment);
+		header.entry_count = count;
+		header.slot_count = slot_count;
+		header.blob_offset = offset;
+		for (Pack::Entry& entry : entries)
+		{
+			entry.offset = offset;
+			offset = align_up(offset + entry.size, _alignment);
+		}
+		header.archive_size = count > 0 ? entries.back().offset + entries.back().size : header.blob_offset;
+
+		const String padding(_alignment, '\0');
+		utils::AtomicFile file{ _archive };
+		UInt64 written = 0;
+		const auto write = [&file, &written](const char* data, Size size) { file.write(data, size); written += size; };
+		const auto pad = [&](UInt64 to) { write(padding.data(), static_cast<Size>(to - written)); };
+
+		write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Pack::Entry));
+		write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(UInt32));
+		write(names.data(), names.size());
+
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			pad(entries[i].offset);
+			if (sources[i]->path.empty())
+			{
+				write(sources[i]->data.data(), sources[i]->data.size());
+				continue;
+			}
+
+			// A file that changed size since it was added would shift every
+			// later blob away from its recorded offset.
+			utils::MappedFile source;
+			if (!source.open(sources[i]->path) || source.size() != entries[i].size)
+				return false;
+			write(source.data(), source.size());
+		}
+		pad(header.archive_size);
+
+		return file.commit();
+	}
+
+	PackWriter::Source& PackWriter::_source(const String& name)
+	{
+		String key = entryName(name);
+		if (const auto it = _names.find(key); it != _names.end())
+			return _sources[it->second];
+
+		_names.emplace(key, _sources.size());
+		return _sources.emplace_back(Source{ std::move(key), {}, {}, 0 });
+	}
+}
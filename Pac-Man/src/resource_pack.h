@@ -0,0 +1,140 @@
+#pragma once
+
+#include "json_save.h"
+
+#include <string_view>
+
+namespace resource
+{
+	// Normalized, '/' separated form of path that names files inside packs
+	// and virtual folders; "" for the directory itself.
+	String entryName(const Path& path);
+
+	// Name that path has below root (an entryName), if it lies under it.
+	// An empty root stands for the working directory.
+	bool entryName(const String& root, const Path& path, String& name);
+
+
+
+	// Read-only archive of many files in one mapping. Layout (little endian):
+	//
+	//   header   magic "PPAK", version, alignment, entry count, slot count,
+	//            offset of the blob area, archive size
+	//   entries  hash, offset, size, name offset, name size per file
+	//   slots    open-addressed table of entry indices keyed by name hash
+	//   names    entry names, '/' separated and relative to the packed root
+	//   blobs    file contents, each starting on an alignment boundary
+	//
+	// find() is one hash, a short probe and a name compare, and returns a
+	// view straight into the mapping, so contents are never copied on the
+	// way to loadFromMemory or the JSON parser. Views stay valid while the
+	// Pack, or a copy of owner(), is alive.
+	//
+	// A mounted pack stands in for a directory: Folder reads of files under
+	// its root are served from the pack when it holds them, and fall back
+	// to loose files otherwise.
+	class Pack
+	{
+	public:
+		static constexpr UInt32 version = 1;
+
+	private:
+		struct Entry;
+
+		friend class PackWriter;
+
+	private:
+		std::shared_ptr<const utils::MappedFile> _file;
+		const Entry* _entries = nullptr;
+		const UInt32* _slots = nullptr;
+		const char* _names = nullptr;
+		UInt32 _count = 0;
+		UInt32 _slot_mask = 0;
+		String _root;
+
+	public:
+		Pack() = default;
+		Pack(const Pack&) = default;
+		Pack(Pack&&) noexcept = default;
+		~Pack() = default;
+
+		Pack& operator= (const Pack&) = default;
+		Pack& operator= (Pack&&) noexcept = default;
+
+		// Maps the archive and checks its header and index. root is the
+		// directory the pack stands in for when mounted.
+		bool open(const Path& archive, const Path& root = {});
+		void close();
+
+		inline bool is_open() const { return _file != nullptr; }
+		inline Size size() const { return _count; }
+
+		bool find(std::string_view name, std::string_view& data) const;
+		inline bool contains(std::string_view name) const { std::string_view data; return find(name, data); }
+
+		std::string_view nameOf(Offset index) const;
+		std::string_view dataOf(Offset index) const;
+
+		// Name that path has inside the pack, if it lies under the root.
+		bool relative(const Path& path, String& name) const;
+
+		inline const std::shared_ptr<const utils::MappedFile>& owner() const { return _file; }
+		inline const String& root() const { return _root; }
+
+	public:
+		// Mounts the archive for every Folder in place of root. Returns false,
+		// leaving loose files in use, if the archive is missing or invalid.
+		static bool mount(const Path& archive, const Path& root = resource::root.path());
+		static void unmount();
+
+		static std::shared_ptr<const Pack> mounted();
+	};
+
+
+
+	// Builds a Pack archive. Files are only recorded by add*(); commit()
+	// lays out the index, then streams every blob into an AtomicFile, so a
+	// failed or interrupted build never replaces an existing archive.
+	class PackWriter
+	{
+	private:
+		struct Source
+		{
+			String name;
+			Path path;
+			String data;
+			UInt64 size;
+		};
+
+	private:
+		Path _archive;
+		Size _alignment;
+		std::vector<Source> _sources;
+		std::unordered_map<String, Offset> _names;
+
+	public:
+		explicit PackWriter(const Path& archive, Size alignment = utils::cache_line_size);
+		PackWriter(const PackWriter&) = delete;
+		PackWriter(PackWriter&&) = delete;
+		~PackWriter() = default;
+
+		PackWriter& operator= (const PackWriter&) = delete;
+		PackWriter& operator= (PackWriter&&) = delete;
+
+		// A name added twice keeps the later contents.
+		void add(const String& name, String data);
+		bool addFile(const String& name, const Path& source);
+
+		// Adds every regular file below directory under its relative path.
+		// Returns the number of files added.
+		Size addFolder(const Path& directory);
+
+		bool commit();
+
+		inline Size size() const { return _sources.size(); }
+		inline Size alignment() const { return _alignment; }
+
+	private:
+		Source& _source(const String& name);
+	};
+}
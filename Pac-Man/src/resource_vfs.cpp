@@ -0,0 +1,152 @@
+#include "resource_vfs.h"
+
+namespace
+{
+	std::mutex mounted_folder_mutex;
+	std::shared_ptr<const resource::VirtualFolder> mounted_folder;
+}
+
+namespace resource
+{
+	VirtualFolder::VirtualFolder(const Path& root) :
+		_root{ entryName(root) },
+		_layers{},
+		_index{}
+	{}
+
+	void VirtualFolder::addFolder(const Path& directory, int priority)
+	{
+		_layers.push_back({ directory, {}, priority });
+	}
+
+	bool VirtualFolder::addPack(const Path& archive, int priority)
+	{
+		Pack pack;
+		if (!pack.open(archive))
+			return false;
+
+		_layers.push_back({ {}, std::move(pack), priority });
+		return true;
+	}
+
+	Size VirtualFolder::build()
+	{
+		// Highest priority first, later layers before earlier ones of the same
+		// priority; the first layer to claim a name keeps it.
+		std::vector<UInt32> order(_layers.size());
+		for (UInt32 i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [this](UInt32 left, UInt32 right) {
+			return _layers[left].priority > _layers[right].priority || (_layers[left].priority == _layers[right].priority && left > right);
+		});
+
+		_index.clear();
+		for (const UInt32 index : order)
+		{
+			const Layer& layer = _layers[index];
+			if (layer.pack.is_open())
+			{
+				for (Offset i = 0; i < layer.pack.size(); ++i)
+					_index.try_emplace(String{ layer.pack.nameOf(i) }, Entry{ index, layer.pack.dataOf(i) });
+				continue;
+			}
+
+			std::error_code error;
+			for (auto it = filesystem::recursive_directory_iterator{ layer.directory, error }; !error && it != filesystem::recursive_directory_iterator{}; it.increment(error))
+			{
+				if (it->is_regular_file(error))
+					_index.try_emplace(it->path().lexically_relative(layer.directory).generic_string(), Entry{ index, {} });
+			}
+		}
+		return _index.size();
+	}
+
+	std::vector<Path> VirtualFolder::directories() const
+	{
+		std::vector<Path> directories;
+		for (const Layer& layer : _layers)
+		{
+			if (!layer.pack.is_open())
+				directories.push_back(layer.directory);
+		}
+		return directories;
+	}
+
+	bool VirtualFolder::find(const String& name, FileView& view, Path& file) const
+	{
+		const auto it = _index.find(name);
+		if (it == _index.end())
+			return false;
+
+		if (it->second.layer == written_layer)
+		{
+			file = Path{ _root } / name;
+			return true;
+		}
+
+		const Layer& layer = _layers[it->second.layer];
+		if (layer.pack.is_open())
+		{
+			view.owner = layer.pack.owner();
+			view.data = it->second.data;
+			file.clear();
+		}
+		else file = layer.directory / name;
+		return true;
+	}
+
+	void VirtualFolder::mount(VirtualFolder folder)
+	{
+		folder.build();
+		auto mounted = std::make_shared<const VirtualFolder>(std::move(folder));
+
+		std::lock_guard lock{ mounted_folder_mutex };
+		mounted_folder = std::move(mounted);
+	}
+
+	void VirtualFolder::unmount()
+	{
+		std::lock_guard lock{ mounted_folder_mutex };
+		mounted_folder.reset();
+	}
+
+	std::shared_ptr<const VirtualFolder> VirtualFolder::mounted()
+	{
+		std::lock_guard lock{ mounted_folder_mutex };
+		return mounted_folder;
+	}
+
+	void VirtualFolder::written(const Path& path)
+	{
+		std::lock_guard lock{ mounted_folder_mutex };
+		String name;
+		if (!mounted_folder || !mounted_folder->relative(path, name) || mounted_folder->contains(name))
+			return;
+
+		auto folder = std::make_shared<VirtualFolder>(*mounted_folder);
+		folder->_index.try_emplace(std::move(name), Entry{ written_layer, {} });
+		mounted_folder = std::move(folder);
+	}
+
+	void VirtualFolder::refresh()
+	{
+		// Layers are walked outside the lock, so reads go on meanwhile.
+		const auto current = mounted();
+		if (!current)
+			return;
+
+		auto folder = std::make_shared<VirtualFolder>(*current);
+		folder->build();
+
+		std::lock_guard lock{ mounted_folder_mutex };
+		if (!mounted_folder)
+			return;
+
+		for (const auto& [name, entry] : mounted_folder->_index)
+		{
+			if (entry.layer == written_layer)
+				folder->_index.try_emplace(name, entry);
+		}
+		mounted_folder = std::move(folder);
+	}
+}
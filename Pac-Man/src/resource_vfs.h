@@ -0,0 +1,101 @@
+#pragma once
+
+#include "resource_pack.h"
+
+namespace resource
+{
+	// Several directories and packs seen as one tree: base assets, then
+	// overlays and mods stacked above them. Where layers hold the same file,
+	// the one with the highest priority wins, and of equal priorities the
+	// one added last. build() walks every layer once and merges them into a
+	// single index of names, so resolving a file is one hash lookup and at
+	// most one open, never a probe of each layer in turn, and a file no
+	// layer holds costs no system call at all.
+	//
+	// The index is a snapshot: files added to a directory layer behind its
+	// back are not seen until the next build() (or refresh()), while edits to
+	// files already indexed are, as they are read from disk. Files written
+	// through a Folder below the mounted root are added as they are created,
+	// resolving to where they were written.
+	//
+	// A mounted VirtualFolder stands in for its root directory: Folder
+	// reads below that root are resolved through the index, ahead of a
+	// mounted Pack.
+	class VirtualFolder
+	{
+	private:
+		struct Layer
+		{
+			Path directory;
+			Pack pack;
+			int priority;
+		};
+
+		struct Entry
+		{
+			UInt32 layer;
+			std::string_view data;
+		};
+
+		// Layer of files added by written(), which live at their path below
+		// the root.
+		static constexpr UInt32 written_layer = 0xffffffffu;
+
+	private:
+		String _root;
+		std::vector<Layer> _layers;
+		std::unordered_map<String, Entry> _index;
+
+	public:
+		explicit VirtualFolder(const Path& root = resource::root.path());
+		VirtualFolder(const VirtualFolder&) = default;
+		VirtualFolder(VirtualFolder&&) noexcept = default;
+		~VirtualFolder() = default;
+
+		VirtualFolder& operator= (const VirtualFolder&) = default;
+		VirtualFolder& operator= (VirtualFolder&&) noexcept = default;
+
+		// Layers only take part once build() has run. A directory that does
+		// not exist adds nothing; addPack() returns false, and adds no layer,
+		// if the archive is missing or invalid.
+		void addFolder(const Path& directory, int priority = 0);
+		bool addPack(const Path& archive, int priority = 0);
+
+		// Merges the layers into the index. Returns the number of files.
+		Size build();
+
+		// Directory layers, from the first added to the last.
+		std::vector<Path> directories() const;
+
+		inline Size size() const { return _index.size(); }
+		inline Size layers() const { return _layers.size(); }
+		inline const String& root() const { return _root; }
+
+		// Resolves name, as relative() gives it: a packed file fills view,
+		// a loose one sets file to the path to open.
+		bool find(const String& name, FileView& view, Path& file) const;
+		inline bool contains(const String& name) const { return _index.contains(name); }
+
+		// Name that path has inside the folder, if it lies under the root.
+		inline bool relative(const Path& path, String& name) const { return entryName(_root, path, name); }
+
+	public:
+		// Builds the index and mounts the folder for every Folder in place of
+		// its root, replacing any folder mounted before.
+		static void mount(VirtualFolder folder);
+		static void unmount();
+
+		static std::shared_ptr<const VirtualFolder> mounted();
+
+		// Makes a file just written at path readable through the mounted
+		// folder, if it lies under the root and no layer holds it yet. The
+		// index is copied rather than changed under readers, so this is meant
+		// for the odd new file, not for every write.
+		static void written(const Path& path);
+
+		// Rebuilds the mounted folder's index from its layers, for files
+		// created or moved into them since it was mounted. Files added by
+		// written() stay readable.
+		static void refresh();
+	};
+}
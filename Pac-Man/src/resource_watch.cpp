@@ -0,0 +1,128 @@
+#include "resource_watch.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace resource
+{
+	FileWatcher::FileWatcher(const Folder& folder, std::chrono::milliseconds debounce) :
+		_root{ folder.path() },
+		_debounce{ debounce },
+		_directories{},
+		_changes{},
+		_buffer{}
+	{
+#if defined(__linux__)
+		_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (_fd < 0)
+			return;
+
+		_buffer.resize(64 * 1024);
+		_watchTree({}, Clock::now(), false);
+#endif
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+#if defined(__linux__)
+		if (_fd >= 0)
+			::close(_fd);
+#endif
+	}
+
+	std::vector<Path> FileWatcher::poll()
+	{
+		std::vector<Path> changed;
+		if (_fd < 0)
+			return changed;
+
+		const Clock::time_point now = Clock::now();
+
+#if defined(__linux__)
+		for (;;)
+		{
+			const ssize_t size = ::read(_fd, _buffer.data(), _buffer.size());
+			if (size < 0 && errno == EINTR)
+				continue;
+			if (size <= 0)
+				break;
+
+			for (const char* ptr = _buffer.data(); ptr < _buffer.data() + size;)
+			{
+				inotify_event event;
+				std::memcpy(&event, ptr, sizeof(event));
+				const char* name = ptr + sizeof(inotify_event);
+				ptr += sizeof(inotify_event) + event.len;
+
+				// Events were dropped, so any file may have changed: report the
+				// whole tree, and watch directories whose creation was lost.
+				if (event.mask & IN_Q_OVERFLOW)
+				{
+					_watchTree({}, now, true);
+					continue;
+				}
+
+				if (event.mask & IN_IGNORED)
+				{
+					_directories.erase(event.wd);
+					continue;
+				}
+
+				const auto directory = _directories.find(event.wd);
+				if (directory == _directories.end() || event.len == 0)
+					continue;
+
+				const Path path = directory->second / name;
+				if (event.mask & IN_ISDIR)
+				{
+					if (event.mask & (IN_CREATE | IN_MOVED_TO))
+						_watchTree(path, now, true);
+				}
+				else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+					_changes[path.generic_string()] = now;
+			}
+		}
+#endif
+
+		for (auto it = _changes.begin(); it != _changes.end();)
+		{
+			if (now - it->second < _debounce)
+				++it;
+			else
+			{
+				changed.emplace_back(it->first);
+				it = _changes.erase(it);
+			}
+		}
+		return changed;
+	}
+
+	// Files already inside a directory that appears later (moved in, or
+	// filled before its watch was added) count as changed.
+	void FileWatcher::_watchTree(const Path& directory, Clock::time_point now, bool report_files)
+	{
+		_watch(directory);
+
+		std::error_code error;
+		for (auto it = filesystem::recursive_directory_iterator{ _root / directory, error }; !error && it != filesystem::recursive_directory_iterator{}; it.increment(error))
+		{
+			const Path relative = it->path().lexically_relative(_root);
+			if (it->is_directory(error))
+				_watch(relative);
+			else if (report_files && it->is_regular_file(error))
+				_changes[relative.generic_string()] = now;
+		}
+	}
+
+	void FileWatcher::_watch([[maybe_unused]] const Path& directory)
+	{
+#if defined(__linux__)
+		const int wd = inotify_add_watch(_fd, (_root / directory).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+		if (wd >= 0)
+			_directories[wd] = directory;
+#endif
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "resource_async.h"
+#include "resource_vfs.h"
+
+namespace resource
+{
+	// Reports files under a Folder that were written or moved into place,
+	// once they have been quiet for the debounce interval, so an editor
+	// saving in several steps yields one change. If the kernel drops events
+	// (a checkout touching thousands of files), every file is reported. Built on inotify, with a
+	// watch per directory: setting up walks the tree once, and afterwards
+	// the cost only depends on the events. Directories created later are
+	// watched as they appear. Elsewhere than on Linux the watcher never
+	// opens and poll() reports nothing.
+	class FileWatcher
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr std::chrono::milliseconds default_debounce{ 150 };
+
+	private:
+		Path _root;
+		int _fd = -1;
+		std::chrono::milliseconds _debounce;
+		std::unordered_map<int, Path> _directories;
+		std::unordered_map<String, Clock::time_point> _changes;
+		std::vector<char> _buffer;
+
+	public:
+		explicit FileWatcher(const Folder& folder, std::chrono::milliseconds debounce = default_debounce);
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher(FileWatcher&&) = delete;
+		~FileWatcher();
+
+		FileWatcher& operator= (const FileWatcher&) = delete;
+		FileWatcher& operator= (FileWatcher&&) = delete;
+
+		inline bool is_open() const { return _fd >= 0; }
+
+		inline Size directories() const { return _directories.size(); }
+		inline const Path& root() const { return _root; }
+
+		// Never blocks. Returns the changed files, relative to the folder,
+		// whose last event is at least the debounce interval old; each change
+		// is reported once.
+		std::vector<Path> poll();
+
+	private:
+		void _watchTree(const Path& directory, Clock::time_point now, bool report_files);
+		void _watch(const Path& directory);
+	};
+
+
+
+	// Keeps the resident entries of a ResourceCache in step with their files
+	// while the game runs. Changed files are reloaded through an AsyncLoader,
+	// so decoding stays off the main thread, and swapped in by the next
+	// update(). Only the changed entries of the listed types are touched.
+	//
+	// With a VirtualFolder mounted over the cache's folder, its directory
+	// layers are watched instead, as they stood at construction. A changed
+	// file that the index does not resolve to (a new file, or one in a
+	// layer that is shadowed) refreshes the index before anything is
+	// reloaded. Pack layers, and a Pack mounted on its own, are not watched.
+	template<ReloadableResource... _Types>
+	class HotReloader
+	{
+	private:
+		ResourceCache& _cache;
+		AsyncLoader& _loader;
+		std::vector<std::unique_ptr<FileWatcher>> _watchers;
+		bool _layered = false;
+		String _prefix;
+
+	public:
+		HotReloader(ResourceCache& cache, AsyncLoader& loader, std::chrono::milliseconds debounce = FileWatcher::default_debounce) :
+			_cache{ cache },
+			_loader{ loader },
+			_watchers{}
+		{
+			// _prefix is the cache folder's name inside the virtual tree.
+			const auto folder = VirtualFolder::mounted();
+			_layered = folder && (entryName(cache.folder().path()) == folder->root() || folder->relative(cache.folder().path(), _prefix));
+			if (!_layered)
+			{
+				_prefix.clear();
+				_watchers.push_back(std::make_unique<FileWatcher>(cache.folder(), debounce));
+				return;
+			}
+
+			for (const Path& directory : folder->directories())
+				_watchers.push_back(std::make_unique<FileWatcher>(Folder{ directory }, debounce));
+		}
+
+		inline bool is_open() const
+		{
+			return std::any_of(_watchers.begin(), _watchers.end(), [](const auto& watcher) { return watcher->is_open(); });
+		}
+
+		// Main thread, once per frame before resources are used: swaps in the
+		// reloads finished since the last call, then starts reloading the
+		// files that changed. Texture uploads still need the loader's own
+		// update(). Returns the number of entries swapped in.
+		Size update()
+		{
+			const Size swapped = _cache.applyReloads();
+
+			std::vector<Path> changed;
+			bool stale = false;
+			const auto folder = _layered ? VirtualFolder::mounted() : nullptr;
+			for (const auto& watcher : _watchers)
+			{
+				for (const Path& path : watcher->poll())
+				{
+					if (!_layered)
+					{
+						changed.push_back(path);
+						continue;
+					}
+
+					const String name = entryName(path);
+					FileView view;
+					Path file;
+					stale = stale || !folder || !folder->find(name, view, file) || file != watcher->root() / name;
+
+					if (_prefix.empty())
+						changed.emplace_back(name);
+					else if (name.size() > _prefix.size() && name[_prefix.size()] == '/' && name.starts_with(_prefix))
+						changed.emplace_back(name.substr(_prefix.size() + 1));
+				}
+			}
+
+			if (stale)
+				VirtualFolder::refresh();
+			for (const Path& path : changed)
+				(_cache.template reload<_Types>(path, _loader), ...);
+			return swapped;
+		}
+	};
+
+	using AssetReloader = HotReloader<sf::Texture, sf::SoundBuffer, Json>;
+}
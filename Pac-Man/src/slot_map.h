@@ -0,0 +1,300 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	class SlotMapHandle
+	{
+	public:
+		static constexpr UInt32 index_bits = 20;
+		static constexpr UInt32 generation_bits = 32 - index_bits;
+
+		static constexpr UInt32 max_index = (UInt32(1) << index_bits) - 1;
+		static constexpr UInt32 max_generation = (UInt32(1) << generation_bits) - 1;
+
+	private:
+		UInt32 _value;
+
+	public:
+		constexpr SlotMapHandle() : _value{ 0 } {}
+		constexpr SlotMapHandle(UInt32 index, UInt32 generation) : _value{ (generation << index_bits) | (index & max_index) } {}
+		constexpr SlotMapHandle(const SlotMapHandle&) = default;
+		constexpr SlotMapHandle(SlotMapHandle&&) noexcept = default;
+		~SlotMapHandle() = default;
+
+		constexpr SlotMapHandle& operator= (const SlotMapHandle&) = default;
+		constexpr SlotMapHandle& operator= (SlotMapHandle&&) noexcept = default;
+
+		constexpr bool operator== (const SlotMapHandle&) const = default;
+		constexpr auto operator<=> (const SlotMapHandle&) const = default;
+
+		constexpr operator bool() const { return generation() != 0; }
+		constexpr bool operator! () const { return generation() == 0; }
+
+		constexpr UInt32 index() const { return _value & max_index; }
+		constexpr UInt32 generation() const { return _value >> index_bits; }
+
+		constexpr UInt32 value() const { return _value; }
+
+		static constexpr SlotMapHandle from_value(UInt32 value) { SlotMapHandle handle; return handle._value = value, handle; }
+	};
+
+	inline void to_json(Json& json, const SlotMapHandle& handle) { json = handle.value(); }
+	inline void from_json(const Json& json, SlotMapHandle& handle) { handle = SlotMapHandle::from_value(json.get<UInt32>()); }
+
+
+
+	// Dense storage addressed by generational handles. Erasing bumps the
+	// slot's generation so old handles stop resolving; a slot whose
+	// generation is used up is retired for good instead of wrapping, so a
+	// stale handle can never reach a later value. Each retirement costs one
+	// slot per max_generation erasures of it.
+	template<typename _Ty>
+	class SlotMap
+	{
+	public:
+		using Handle = SlotMapHandle;
+
+		using iterator = typename std::vector<_Ty>::iterator;
+		using const_iterator = typename std::vector<_Ty>::const_iterator;
+
+	private:
+		static constexpr UInt32 invalid_index = SlotMapHandle::max_index;
+
+		// Generation of a slot that is never handed out again; no handle can
+		// carry it.
+		static constexpr UInt32 retired_generation = SlotMapHandle::max_generation + 1;
+
+		struct Slot
+		{
+			UInt32 index;
+			UInt32 generation;
+		};
+
+	private:
+		std::vector<_Ty> _values;
+		std::vector<UInt32> _owners;
+		std::vector<Slot> _slots;
+		UInt32 _free = invalid_index;
+
+	public:
+		SlotMap() = default;
+		SlotMap(const SlotMap&) = default;
+		SlotMap(SlotMap&&) noexcept = default;
+		~SlotMap() = default;
+
+		SlotMap& operator= (const SlotMap&) = default;
+		SlotMap& operator= (SlotMap&&) noexcept = default;
+
+		inline iterator begin() { return _values.begin(); }
+		inline const_iterator begin() const { return _values.begin(); }
+		inline const_iterator cbegin() const { return _values.cbegin(); }
+
+		inline iterator end() { return _values.end(); }
+		inline const_iterator end() const { return _values.end(); }
+		inline const_iterator cend() const { return _values.cend(); }
+
+		inline bool empty() const { return _values.empty(); }
+		inline Size size() const { return _values.size(); }
+		inline Size capacity() const { return _slots.size(); }
+
+		inline operator bool() const { return !_values.empty(); }
+		inline bool operator! () const { return _values.empty(); }
+
+		inline _Ty* data() { return _values.data(); }
+		inline const _Ty* data() const { return _values.data(); }
+
+		void reserve(Size count)
+		{
+			_values.reserve(count);
+			_owners.reserve(count);
+			_slots.reserve(count);
+		}
+
+		template<typename... _Args>
+		Handle emplace(_Args&&... args)
+		{
+			const bool fresh = _free == invalid_index;
+			if (fresh && _slots.size() >= invalid_index)
+				throw std::length_error{ "SlotMap capacity exceeded" };
+			const UInt32 slot_index = fresh ? static_cast<UInt32>(_slots.size()) : _free;
+
+			// Nothing is claimed until every step has succeeded, so a throwing
+			// constructor or allocation leaves the map as it was.
+			_values.emplace_back(std::forward<_Args>(args)...);
+			try
+			{
+				_owners.push_back(slot_index);
+				try
+				{
+					if (fresh)
+						_slots.push_back({ invalid_index, 1 });
+				}
+				catch (...) { _owners.pop_back(); throw; }
+			}
+			catch (...) { _values.pop_back(); throw; }
+
+			Slot& slot = _slots[slot_index];
+			if (!fresh)
+				_free = slot.index;
+			slot.index = static_cast<UInt32>(_values.size() - 1);
+
+			return { slot_index, slot.generation };
+		}
+
+		inline Handle insert(const _Ty& value) { return emplace(value); }
+		inline Handle insert(_Ty&& value) { return emplace(std::move(value)); }
+
+		bool erase(Handle handle)
+		{
+			if (!contains(handle))
+				return false;
+
+			Slot& slot = _slots[handle.index()];
+			const UInt32 index = slot.index;
+			const UInt32 last = static_cast<UInt32>(_values.size() - 1);
+
+			if (index != last)
+			{
+				_values[index] = std::move(_values[last]);
+				_owners[index] = _owners[last];
+				_slots[_owners[index]].index = index;
+			}
+			_values.pop_back();
+			_owners.pop_back();
+
+			_release(handle.index());
+			return true;
+		}
+
+		inline bool contains(Handle handle) const
+		{
+			return handle && handle.index() < _slots.size() && _slots[handle.index()].generation == handle.generation();
+		}
+
+		inline _Ty* get(Handle handle) { return contains(handle) ? &_values[_slots[handle.index()].index] : nullptr; }
+		inline const _Ty* get(Handle handle) const { return contains(handle) ? &_values[_slots[handle.index()].index] : nullptr; }
+
+		inline Handle handle_of(Offset dense_index) const
+		{
+			const UInt32 slot_index = _owners[dense_index];
+			return { slot_index, _slots[slot_index].generation };
+		}
+
+		inline Handle handle_of(const_iterator it) const { return handle_of(static_cast<Offset>(it - _values.begin())); }
+
+		void clear()
+		{
+			for (UInt32 owner : _owners)
+				_release(owner);
+
+			_values.clear();
+			_owners.clear();
+		}
+
+		inline _Ty& at(Handle handle)
+		{
+			if (_Ty* value = get(handle))
+				return *value;
+			throw std::out_of_range{ "invalid SlotMap handle" };
+		}
+		inline const _Ty& at(Handle handle) const
+		{
+			if (const _Ty* value = get(handle))
+				return *value;
+			throw std::out_of_range{ "invalid SlotMap handle" };
+		}
+
+		inline _Ty& operator[] (Handle handle) { return _values[_slots[handle.index()].index]; }
+		inline const _Ty& operator[] (Handle handle) const { return _values[_slots[handle.index()].index]; }
+
+		Json serialize() const
+		{
+			Json generations = Json::array();
+			for (const Slot& slot : _slots)
+				generations.push_back(slot.generation);
+
+			Json entries = Json::array();
+			for (Offset i = 0; i < _values.size(); ++i)
+			{
+				Json value;
+				if constexpr (json::JsonSerializableOnly<_Ty>)
+					value = _values[i].serialize();
+				else value = _values[i];
+				entries.push_back({ { "handle", handle_of(i) }, { "value", std::move(value) } });
+			}
+
+			return { { "generations", std::move(generations) }, { "entries", std::move(entries) } };
+		}
+
+		void deserialize(const Json& json)
+		{
+			const Json& generations = json.at("generations");
+			if (generations.size() > SlotMapHandle::max_index)
+				throw json::JsonException{ "too many SlotMap slots in json" };
+
+			// Retired slots are saved with retired_generation, so they stay out
+			// of the free list once loaded.
+			std::vector<Slot> slots;
+			slots.reserve(generations.size());
+			for (const Json& entry : generations)
+			{
+				const UInt32 generation = entry.get<UInt32>();
+				if ((generation < 1 || generation > SlotMapHandle::max_generation) && generation != retired_generation)
+					throw json::JsonException{ "invalid SlotMap generation in json" };
+				slots.push_back({ invalid_index, generation });
+			}
+
+			std::vector<_Ty> values;
+			std::vector<UInt32> owners;
+			for (const Json& entry : json.at("entries"))
+			{
+				const Handle handle = entry.at("handle").get<Handle>();
+				if (handle.index() >= slots.size() || slots[handle.index()].index != invalid_index || slots[handle.index()].generation != handle.generation())
+					throw json::JsonException{ "invalid SlotMap handle in json" };
+
+				if constexpr (json::JsonSerializableOnly<_Ty>)
+					values.emplace_back().deserialize(entry.at("value"));
+				else values.push_back(entry.at("value").get<_Ty>());
+
+				owners.push_back(handle.index());
+				slots[handle.index()].index = static_cast<UInt32>(values.size() - 1);
+			}
+
+			UInt32 free = invalid_index;
+			for (Offset i = slots.size(); i-- > 0;)
+			{
+				if (slots[i].index == invalid_index && slots[i].generation != retired_generation)
+					slots[i].index = free, free = static_cast<UInt32>(i);
+			}
+
+			_values = std::move(values);
+			_owners = std::move(owners);
+			_slots = std::move(slots);
+			_free = free;
+		}
+
+	private:
+		void _release(UInt32 slot_index)
+		{
+			Slot& slot = _slots[slot_index];
+			slot.index = invalid_index;
+			if (slot.generation >= SlotMapHandle::max_generation)
+			{
+				slot.generation = retired_generation;
+				return;
+			}
+
+			++slot.generation;
+			slot.index = _free;
+			_free = slot_index;
+		}
+	};
+
+	template<typename _Ty>
+	inline void to_json(Json& json, const SlotMap<_Ty>& map) { json = map.serialize(); }
+
+	template<typename _Ty>
+	inline void from_json(const Json& json, SlotMap<_Ty>& map) { map.deserialize(json); }
+}
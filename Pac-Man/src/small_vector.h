@@ -0,0 +1,283 @@
+#pragma once
+
+#include "common.h"
+
+#include <cstring>
+
+namespace utils
+{
+	template<typename _Ty, Size _InlineCount = 4>
+	class SmallVector
+	{
+		static_assert(_InlineCount > 0, "SmallVector needs at least one inline slot");
+
+	public:
+		using value_type = _Ty;
+		using iterator = _Ty*;
+		using const_iterator = const _Ty*;
+
+		static constexpr Size inline_capacity = _InlineCount;
+
+	private:
+		static constexpr bool trivially_relocatable = std::is_trivially_copyable_v<_Ty>;
+
+		_Ty* _data;
+		Size _size = 0;
+		Size _capacity = _InlineCount;
+		alignas(_Ty) Byte _inline[sizeof(_Ty) * _InlineCount];
+
+	public:
+		inline iterator begin() { return _data; }
+		inline const_iterator begin() const { return _data; }
+		inline const_iterator cbegin() const { return _data; }
+
+		inline iterator end() { return _data + _size; }
+		inline const_iterator end() const { return _data + _size; }
+		inline const_iterator cend() const { return _data + _size; }
+
+	private:
+		inline _Ty* _inline_data() { return std::launder(reinterpret_cast<_Ty*>(_inline)); }
+
+		inline bool _is_inline() const { return _data == reinterpret_cast<const _Ty*>(_inline); }
+
+		static void _relocate(_Ty* src, Size count, _Ty* dst)
+		{
+			if constexpr (trivially_relocatable)
+			{
+				if (count > 0)
+					std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(_Ty));
+			}
+			else
+			{
+				std::uninitialized_move_n(src, count, dst);
+				std::destroy_n(src, count);
+			}
+		}
+
+		void _grow(Size min_capacity)
+		{
+			const Size capacity = std::max(min_capacity, _capacity * 2);
+			_Ty* data = std::allocator<_Ty>{}.allocate(capacity);
+
+			try { _relocate(_data, _size, data); }
+			catch (...) { std::allocator<_Ty>{}.deallocate(data, capacity); throw; }
+
+			_release();
+			_data = data;
+			_capacity = capacity;
+		}
+
+		void _release()
+		{
+			if (!_is_inline())
+				std::allocator<_Ty>{}.deallocate(_data, _capacity);
+			_data = _inline_data();
+			_capacity = _InlineCount;
+		}
+
+		void _steal(SmallVector& other)
+		{
+			if (other._is_inline())
+			{
+				_relocate(other._data, other._size, _data);
+				_size = other._size;
+			}
+			else
+			{
+				_data = other._data;
+				_size = other._size;
+				_capacity = other._capacity;
+				other._data = other._inline_data();
+				other._capacity = _InlineCount;
+			}
+			other._size = 0;
+		}
+
+	public:
+		SmallVector() : _data{ _inline_data() } {}
+		SmallVector(std::initializer_list<_Ty> values) : SmallVector{} { assign(values.begin(), values.end()); }
+		SmallVector(const SmallVector& other) : SmallVector{} { assign(other.begin(), other.end()); }
+		SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<_Ty>) : SmallVector{} { _steal(other); }
+		~SmallVector() { clear(), _release(); }
+
+		SmallVector& operator= (const SmallVector& right)
+		{
+			if (this != &right)
+				assign(right.begin(), right.end());
+			return *this;
+		}
+		SmallVector& operator= (SmallVector&& right) noexcept(std::is_nothrow_move_constructible_v<_Ty>)
+		{
+			if (this != &right)
+			{
+				clear(), _release();
+				_steal(right);
+			}
+			return *this;
+		}
+
+		template<typename _InputIt>
+		void assign(_InputIt first, _InputIt last)
+		{
+			clear();
+			if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<_InputIt>::iterator_category>)
+				reserve(static_cast<Size>(std::distance(first, last)));
+			for (; first != last; ++first)
+				emplace_back(*first);
+		}
+
+		inline bool empty() const { return _size == 0; }
+		inline Size size() const { return _size; }
+		inline Size capacity() const { return _capacity; }
+		inline bool is_inline() const { return _is_inline(); }
+
+		inline operator bool() const { return _size > 0; }
+		inline bool operator! () const { return _size == 0; }
+
+		inline _Ty* data() { return _data; }
+		inline const _Ty* data() const { return _data; }
+
+		inline void reserve(Size capacity)
+		{
+			if (capacity > _capacity)
+				_grow(capacity);
+		}
+
+		template<typename... _Args>
+		_Ty& emplace_back(_Args&&... args)
+		{
+			if (_size == _capacity)
+			{
+				_Ty value{ std::forward<_Args>(args)... };
+				_grow(_size + 1);
+				return *new (_data + _size++) _Ty{ std::move(value) };
+			}
+			return *new (_data + _size++) _Ty{ std::forward<_Args>(args)... };
+		}
+
+		inline _Ty& push_back(const _Ty& value) { return emplace_back(value); }
+		inline _Ty& push_back(_Ty&& value) { return emplace_back(std::move(value)); }
+
+		inline void pop_back() { std::destroy_at(_data + --_size); }
+
+		template<typename... _Args>
+		iterator emplace(const_iterator pos, _Args&&... args)
+		{
+			const Offset index = static_cast<Offset>(pos - _data);
+			if (index >= _size)
+				return &emplace_back(std::forward<_Args>(args)...);
+
+			_Ty value{ std::forward<_Args>(args)... };
+			if (_size == _capacity)
+				_grow(_size + 1);
+
+			new (_data + _size) _Ty{ std::move(_data[_size - 1]) };
+			std::move_backward(_data + index, _data + _size - 1, _data + _size);
+			_data[index] = std::move(value);
+
+			return ++_size, _data + index;
+		}
+
+		inline iterator insert(const_iterator pos, const _Ty& value) { return emplace(pos, value); }
+		inline iterator insert(const_iterator pos, _Ty&& value) { return emplace(pos, std::move(value)); }
+
+		iterator erase(const_iterator pos)
+		{
+			_Ty* elem = _data + (pos - _data);
+			std::move(elem + 1, _data + _size, elem);
+			pop_back();
+			return elem;
+		}
+
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			_Ty* from = _data + (first - _data);
+			_Ty* to = _data + (last - _data);
+			if (from != to)
+			{
+				_Ty* new_end = std::move(to, _data + _size, from);
+				std::destroy(new_end, _data + _size);
+				_size = static_cast<Size>(new_end - _data);
+			}
+			return from;
+		}
+
+		iterator swap_erase(const_iterator pos)
+		{
+			_Ty* elem = _data + (pos - _data);
+			if (elem != _data + _size - 1)
+				*elem = std::move(_data[_size - 1]);
+			pop_back();
+			return elem;
+		}
+
+		void resize(Size count)
+		{
+			if (count < _size)
+				erase(_data + count, _data + _size);
+			else
+			{
+				reserve(count);
+				while (_size < count)
+					emplace_back();
+			}
+		}
+
+		inline void clear()
+		{
+			std::destroy_n(_data, _size);
+			_size = 0;
+		}
+
+		void shrink_to_fit()
+		{
+			if (_is_inline() || _size == _capacity)
+				return;
+
+			if (_size <= _InlineCount)
+			{
+				_Ty* data = _data;
+				const Size capacity = _capacity;
+				_relocate(data, _size, _inline_data());
+				std::allocator<_Ty>{}.deallocate(data, capacity);
+				_data = _inline_data();
+				_capacity = _InlineCount;
+			}
+			else
+			{
+				_Ty* data = std::allocator<_Ty>{}.allocate(_size);
+				_relocate(_data, _size, data);
+				std::allocator<_Ty>{}.deallocate(_data, _capacity);
+				_data = data;
+				_capacity = _size;
+			}
+		}
+
+		inline _Ty& at(Offset index)
+		{
+			if (index >= _size)
+				throw std::out_of_range{ "SmallVector index out of range" };
+			return _data[index];
+		}
+		inline const _Ty& at(Offset index) const
+		{
+			if (index >= _size)
+				throw std::out_of_range{ "SmallVector index out of range" };
+			return _data[index];
+		}
+
+		inline _Ty& front() { return _data[0]; }
+		inline const _Ty& front() const { return _data[0]; }
+
+		inline _Ty& back() { return _data[_size - 1]; }
+		inline const _Ty& back() const { return _data[_size - 1]; }
+
+		inline SmallVector& operator<< (const _Ty& right) { return push_back(right), *this; }
+		inline SmallVector& operator<< (_Ty&& right) { return push_back(std::move(right)), *this; }
+
+		inline _Ty& operator[] (Offset index) { return _data[index]; }
+		inline const _Ty& operator[] (Offset index) const { return _data[index]; }
+
+		bool operator== (const SmallVector& right) const { return std::equal(begin(), end(), right.begin(), right.end()); }
+	};
+}
@@ -0,0 +1,120 @@
+#include "thread_pool.h"
+
+namespace utils
+{
+	ThreadPool::ThreadPool(Size threads)
+	{
+		threads = threads > 0 ? threads : default_size();
+		_workers.reserve(threads);
+		for (Size i = 0; i < threads; ++i)
+			_workers.emplace_back([this] { _run(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ _mutex };
+			_stop = true;
+		}
+		_ready.notify_all();
+
+		for (std::thread& worker : _workers)
+			worker.join();
+	}
+
+	void ThreadPool::submit(Function<void()> task)
+	{
+		{
+			std::lock_guard lock{ _mutex };
+			_tasks.push(std::move(task));
+		}
+		_ready.notify_one();
+	}
+
+	void ThreadPool::parallel_for(Size count, const Function<void(Offset)>& action)
+	{
+		struct State
+		{
+			std::atomic<Size> next{ 0 };
+			std::atomic<Size> active{ 0 };
+			std::mutex error_mutex;
+			std::exception_ptr error;
+		};
+
+		// Helpers that only start after the caller has finished claim nothing
+		// and never touch action, so the caller does not wait for them.
+		const auto state = std::make_shared<State>();
+		const auto work = [state, &action, count] {
+			for (Size index = state->next.fetch_add(1, std::memory_order_acq_rel); index < count; index = state->next.fetch_add(1, std::memory_order_acq_rel))
+			{
+				try { action(index); }
+				catch (...)
+				{
+					std::lock_guard lock{ state->error_mutex };
+					if (!state->error)
+						state->error = std::current_exception();
+				}
+			}
+		};
+
+		const Size helpers = std::min(size(), count > 0 ? count - 1 : 0);
+		for (Size i = 0; i < helpers; ++i)
+		{
+			submit([state, work] {
+				state->active.fetch_add(1, std::memory_order_acq_rel);
+				work();
+				if (state->active.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					state->active.notify_all();
+			});
+		}
+
+		work();
+
+		for (Size active = state->active.load(std::memory_order_acquire); active > 0; active = state->active.load(std::memory_order_acquire))
+			state->active.wait(active, std::memory_order_acquire);
+
+		if (state->error)
+			std::rethrow_exception(state->error);
+	}
+
+	Size ThreadPool::default_size()
+	{
+		return std::max<Size>(std::thread::hardware_concurrency(), 1);
+	}
+
+	void ThreadPool::run_batch(Size count, Size threads, const Function<void(Offset)>& action)
+	{
+		if (threads == 1 || count <= 1)
+		{
+			for (Offset index = 0; index < count; ++index)
+				action(index);
+		}
+		else if (threads == 0)
+			shared().parallel_for(count, action);
+		else ThreadPool{ threads - 1 }.parallel_for(count, action);
+	}
+
+	ThreadPool& ThreadPool::shared()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::_run()
+	{
+		for (;;)
+		{
+			Function<void()> task;
+			{
+				std::unique_lock lock{ _mutex };
+				_ready.wait(lock, [this] { return _stop || !_tasks.empty(); });
+				if (_stop && _tasks.empty())
+					return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop();
+			}
+			task();
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.h"
+
+#include <condition_variable>
+
+namespace utils
+{
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread> _workers;
+		std::queue<Function<void()>> _tasks;
+		std::mutex _mutex;
+		std::condition_variable _ready;
+		bool _stop = false;
+
+	public:
+		explicit ThreadPool(Size threads = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		~ThreadPool();
+
+		ThreadPool& operator= (const ThreadPool&) = delete;
+		ThreadPool& operator= (ThreadPool&&) = delete;
+
+		inline Size size() const { return _workers.size(); }
+
+		void submit(Function<void()> task);
+
+		// Runs action(0) .. action(count - 1) on the workers and the calling
+		// thread, and returns once all of them have finished. The first
+		// exception thrown by an action is rethrown here.
+		void parallel_for(Size count, const Function<void(Offset)>& action);
+
+	public:
+		static Size default_size();
+
+		// parallel_for with an explicit thread count: 0 uses the shared pool,
+		// 1 runs on the calling thread and n uses a temporary pool of n - 1
+		// workers next to the caller.
+		static void run_batch(Size count, Size threads, const Function<void(Offset)>& action);
+
+		static ThreadPool& shared();
+
+	private:
+		void _run();
+	};
+}
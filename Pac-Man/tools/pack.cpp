@@ -0,0 +1,51 @@
+#include "resource_pack.h"
+
+namespace
+{
+	int usage()
+	{
+		std::cerr << "usage: pacman_pack <directory> <archive.pak> [alignment]\n"
+			"       pacman_pack --list <archive.pak>\n";
+		return 2;
+	}
+
+	int list(const Path& archive)
+	{
+		resource::Pack pack;
+		if (!pack.open(archive))
+		{
+			std::cerr << "cannot open " << archive.string() << '\n';
+			return 1;
+		}
+
+		for (Offset i = 0; i < pack.size(); ++i)
+			std::cout << pack.dataOf(i).size() << '\t' << pack.nameOf(i) << '\n';
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// pacman_pack data data.pak packs every file below data/; Folder reads
+	// then prefer it once resource::Pack::mount("data.pak") has been called.
+	if (argc == 3 && String{ argv[1] } == "--list")
+		return list(Path{ argv[2] });
+	if (argc != 3 && argc != 4)
+		return usage();
+
+	const Path directory{ argv[1] };
+	const Path archive{ argv[2] };
+	const Size alignment = argc == 4 ? static_cast<Size>(std::stoull(argv[3])) : utils::cache_line_size;
+
+	resource::PackWriter writer{ archive, alignment };
+	const Size count = writer.addFolder(directory);
+	if (!writer.commit())
+	{
+		std::cerr << "cannot write " << archive.string() << '\n';
+		return 1;
+	}
+
+	std::error_code error;
+	std::cout << "packed " << count << " files into " << archive.string() << " (" << filesystem::file_size(archive, error) << " bytes)\n";
+	return 0;
+}